@@ -9,34 +9,43 @@
 *       minimizing f(n) = g(n) + h(n), where g(n) is the path_cost to the
 *       current_node and h(n) is the heuristic function to arrive at the goal.
 *
-*       NOTE: To ease implementation, the A* Search actually uses the same FIFO
-*       as the BFS uses.  Therefore, to ensure no intermingling of search nodes in
-*       the queue, the BFS must be run first, and the A* Search runs after draining
-*       the BFS queue completely.
+*       The Open Set is kept in a bucketed priority queue (see the utility
+*       astar_open_list.c), so that selecting the best node does not require
+*       a scan over every node in the Open Set.
+*
+*       The heuristic is looked up in the master brick's distance map (see
+*       master_distance_map.c), which is computed when the puzzle is loaded.
+*       Unless it is turned off, the heuristic also looks up the state in a
+*       Pattern Database (see pattern_database.c), which is built (or loaded)
+*       for the puzzle before the search starts.
 *
 * PUBLIC FUNCTIONS :
 *
-*       int aStarSearch(int, int, int, int **)
+*       int aStarSearch(SOLVER_CONTEXT *, BOARD *)
 *
 * AUTHOR : Philip Cheng
 * DATE   : 18 October 2017
 *
 ************************************************************************/
 
-#define WORST_CASE_DISTANCE 1000
-
 /**
  * Function: get_heuristic
  *
- * Returns a h(n) heuristic function that is an admissible and consistent
- * heuristic, based on the board dimensions and game's board_state.  Basically,
- * the heuristic returned here is the "Manhattan distance" from the 2-Block to
- * the Minus-1-Block (i.e. the Start Block to the End Block).
+ * Returns a h(n) heuristic function that is an admissible heuristic, based on
+ * the board dimensions (of the puzzle in <ctx>) and game's board_state.  Basically, the heuristic
+ * returned here is the master brick's distance map value (its distance to the
+ * goal, plus the bricks in its way), or the Pattern Database's distance, if
+ * there is one and it is larger.  With the distance map turned off, it is the
+ * "Manhattan distance" from the 2-Block to the Minus-1-Block (i.e. the Start
+ * Block to the End Block) instead.
  */
 
-int get_heuristic(int board_height, int board_width, int max_block_num, int **board_state) {
+int get_heuristic(SOLVER_CONTEXT *ctx, BOARD *board_state) {
 
   int i,j = 0;
+  int h = 0;
+  int board_height = ctx->board_height;
+  int board_width  = ctx->board_width;
 
   /* Indexes of the Start and End Blocks */
   int start_block_row = -1;
@@ -48,12 +57,24 @@ int get_heuristic(int board_height, int board_width, int max_block_num, int **bo
   int row_range = 0;
   int col_range = 0;
 
+  /* Look up the Master Brick's Distance Map (and the Pattern Database) */
+  if (use_distance_map) {
+    h = getMasterDistanceHeuristic(&ctx->distance_map, &ctx->keys, board_state);
+    if (patternDatabaseReady(ctx)) {
+      i = getPatternDatabaseHeuristic(ctx, board_state);
+      if (i > h) {
+        h = i;
+      }
+    }
+    return h;
+  }
+
   /* Find these Blocks in Question */
   for (i = 0; i < board_height; i++) {
     for (j = 0; j < board_width; j++) {
 
       /* Start Block Found */
-      if (board_state[i][j] == 2) {
+      if (board_state->cells[i * board_width + j] == 2) {
         if (i > start_block_row) {
           start_block_row = i;
         }
@@ -63,7 +84,7 @@ int get_heuristic(int board_height, int board_width, int max_block_num, int **bo
       }
 
       /* End Block Found */
-      if (board_state[i][j] == -1) {
+      if (board_state->cells[i * board_width + j] == -1) {
         if (i > end_block_row) {
           end_block_row = i;
         }
@@ -91,159 +112,123 @@ int get_heuristic(int board_height, int board_width, int max_block_num, int **bo
 }
 
 
-/**
- * Function: getBestNode
- *
- * Returns a pointer to the Node that provides the lowest expected path from
- * start state to goal state (i.e. minimizes f(n) = g(h) + h(n)).
- */
-
-STATE_NODE* getBestNode(int board_height, int board_width, int max_block_num, int **board_state) {
-
-  STATE_NODE* search_node = bfs_fifo_head;
-  STATE_NODE* shortest_node = NULL;
-
-  int shortest_path = WORST_CASE_DISTANCE;
-  int f_of_n = 0;
-  int g_of_n = 0;
-  int h_of_n = 0;
-
-  /* Loop through the FIFO, finding the Node with the lowest f(n) */
-  while (search_node != NULL) {
-
-    /* Calculate f(n) */
-    g_of_n = search_node->path_cost;
-    h_of_n = get_heuristic(board_height, board_width, max_block_num, search_node->board_state);
-    f_of_n = g_of_n + h_of_n;
-
-    /* Update Shortest Path */
-    if (f_of_n < shortest_path) {
-      shortest_path = f_of_n;
-      shortest_node = search_node;
-    }
-
-    search_node = search_node->next;
-  }
-
-  return shortest_node;
-
-}
-
-
-/**
- * Function: removeNode
- *
- * Removes the Node from the bfsQueue (really just makes the Queue skip over the Node)
- */
-
-void removeNode(STATE_NODE* nodeToRemove) {
-
-  STATE_NODE* current_node = bfs_fifo_head;
-  STATE_NODE* next_node = NULL;
-
-  /* If the first Node is the one to remove, just dequeue */
-  if (compareStates(bfs_fifo_head->board_state, nodeToRemove->board_state)) {
-    bfsDequeue();
-    return;
-  }
-
-  /* Loop throught the FIFO looking for the Node to remove */
-  while (current_node != NULL) {
-    next_node = current_node->next;
-    if (next_node != NULL && compareStates(next_node->board_state, nodeToRemove->board_state)) {
-      current_node->next = next_node->next;
-      return;
-    }
-    current_node = current_node->next;
-  }
-}
-
-
 /**
  * Function: aStarSearch
  *
  * Performs an A* Search, i.e. travelling along the path that minimizes
- * f(n) = g(n) + h(n)s
+ * f(n) = g(n) + h(n).  The h(n) of each state is calculated only once, when
+ * the state is generated, and is cached in the State Node.  The search's
+ * memory (open list, arena, path store, and closed set) is in the <ctx>.
  */
 
-int aStarSearch(int board_height, int board_width, int max_block_num, int **board_state) {
+int aStarSearch(SOLVER_CONTEXT *ctx, BOARD *board_state) {
 
   int i = 0;
   int num_moves = 0;
-  MOVE *available_moves = NULL;
+  MOVE  available_moves[MAX_AVAILABLE_MOVES];
   STATE_NODE* current_state_node = NULL;
 
-  int **next_board_state = NULL;
-  int   next_board_depth = 0;
+  BOARD    next_board_state;
+  STATE_KEY next_board_key;
+  uint64_t current_board_hash = 0;
+  uint64_t next_board_hash = 0;
+  int      next_board_depth = 0;
 
-  char *next_board_hash  = NULL;
   int   hash_table_value = 0;
 
-  /* Make sure the BFS queue is empty before we get started */
-  drainQueue();
+  /* Make sure the A* Open List is empty before we get started */
+  astarClearOpenList(&ctx->open_list);
+
+  /* Get the Pattern Database for this puzzle (if it is used) */
+  preparePatternDatabase(ctx, board_state);
 
-  /* Create Root State Node for the BFS */
-  STATE_NODE root_state_node;
-  root_state_node.path_cost = 0;
-  root_state_node.board_state = board_state;
-  root_state_node.move_from_parent = NULL;
-  root_state_node.parent = NULL;
-  root_state_node.next = NULL;
+  /* Start a new Path Store (with the Root State) */
+  pathStoreReset(&ctx->paths);
 
-  /* Enqueue Root Node into BFS FIFO Queue */
-  bfsEnqueue(root_state_node.board_state, NULL, NULL);
+  /* Push Root Node into the A* Open List */
+  next_board_state = *board_state;
+  astarPushOpenList(&ctx->open_list, &ctx->arena, &next_board_state, 0, PATH_STORE_ROOT,
+                    get_heuristic(ctx, &next_board_state));
 
   /* Initialize Hash Table of Visited States (a.k.a. "Closed Set") */
-  initStateHashTable(board_height, board_width, max_block_num);
+  initStateHashTable(&ctx->closed_set, getStateKeyWords(&ctx->keys));
 
   /* Add Root State to the Closed Set */
-  insertIntoStateHashTable(getStateHashKey(board_state), 0);
+  getStateKey(&ctx->keys, &next_board_state, &next_board_key);
+  insertIntoStateHashTable(&ctx->closed_set, &next_board_key, getBoardHashKey(ctx, &next_board_state), 0);
 
-  /* Loop through states in FIFO Queue */
-  while(!bfsQueueIsEmpty()) {
+  /* Loop through states in the Open List */
+  while(!astarOpenListIsEmpty(&ctx->open_list)) {
 
     /* Select the next State Node ==>  KEY TO THE A* SEARCH !!! */
-    current_state_node = getBestNode(board_height, board_width, max_block_num, board_state);
-    removeNode(current_state_node);
+    current_state_node = astarPopOpenList(&ctx->open_list);
+
+    /* Skip stale Nodes (a shorter path to this state was found later) */
+    getStateKey(&ctx->keys, &current_state_node->board_state, &next_board_key);
+    current_board_hash = getBoardHashKey(ctx, &current_state_node->board_state);
+    hash_table_value = getHashTableValue(&ctx->closed_set, &next_board_key, current_board_hash);
+    if (hash_table_value < current_state_node->path_cost) {
+      arenaFreeNode(&ctx->arena, current_state_node);
+      continue;
+    }
 
     /* Generate list of legal moves from Current State */
-    num_moves = getAllAvailableMoves(current_state_node->board_state, &available_moves);
+    num_moves = getAllAvailableMoves(ctx, &current_state_node->board_state, available_moves);
+    countExpandedNode(&ctx->stats, num_moves);
+
+    /* Each move is made in place on one copy of the Current State (with its
+       canonical key and hash updated incrementally), then unmade */
+    next_board_state = current_state_node->board_state;
+    next_board_depth = current_state_node->path_cost + 1;
 
     for (i = 0; i < num_moves; i++) {
 
-      /* Generate and Normalize Next State */
-      next_board_state = applyMoveCloning(current_state_node->board_state, available_moves[i]);
-      next_board_depth = current_state_node->path_cost + 1;
-      normalizeState(next_board_state);
+      /* Generate Next State */
+      next_board_hash = makeMove(ctx, &next_board_state, available_moves[i], current_board_hash, &next_board_key);
 
       /* Check if goal state is reached */
-      if (checkGameComplete(next_board_state)) {
+      if (checkMoveCompletesGame(ctx, &next_board_state, available_moves[i])) {
 
         /* Print path to goal state (and print the goal state) */
-        printPath(current_state_node);
-        printMove(&available_moves[i]);
-        printState(next_board_state);
-        free(next_board_state);
+        printStoredSolution(ctx, board_state, current_state_node->path_index, available_moves[i]);
+        ctx->stats.closed_set_size = ctx->closed_set.count;
+        astarClearOpenList(&ctx->open_list);
+        arenaReset(&ctx->arena);
         return next_board_depth;
       }
 
-      /* Add to FIFO Queue (if not already part of the closed Set) */
-      next_board_hash = getStateHashKey(next_board_state);
-      hash_table_value = getHashTableValue(next_board_hash);
-      if (hash_table_value >= 0) {
-        free(next_board_state);
-        free(next_board_hash);
+      /* Add to Open List (if not already reached with a lower path cost) */
+      hash_table_value = getHashTableValue(&ctx->closed_set, &next_board_key, next_board_hash);
+
+      if (hash_table_value < 0) {
+        astarPushOpenList(&ctx->open_list, &ctx->arena, &next_board_state, next_board_depth,
+                          pathStoreAdd(&ctx->paths, current_state_node->path_index,
+                                       encodeMove(&ctx->keys, available_moves[i])),
+                          get_heuristic(ctx, &next_board_state));
+        insertIntoStateHashTable(&ctx->closed_set, &next_board_key, next_board_hash, next_board_depth);
       }
-      else
+      else if (hash_table_value > next_board_depth)
       {
-        bfsEnqueue(next_board_state, &available_moves[i], current_state_node);
-        insertIntoStateHashTable(next_board_hash, next_board_depth);
+        astarPushOpenList(&ctx->open_list, &ctx->arena, &next_board_state, next_board_depth,
+                          pathStoreAdd(&ctx->paths, current_state_node->path_index,
+                                       encodeMove(&ctx->keys, available_moves[i])),
+                          get_heuristic(ctx, &next_board_state));
+        updateHashTableValue(&ctx->closed_set, &next_board_key, next_board_hash, next_board_depth);
       }
 
+      /* Back to the Current State */
+      unmakeMove(ctx, &next_board_state, available_moves[i], next_board_hash, &next_board_key);
+
     }
+
+    /* The Current State is done with (its path is in the Path Store) */
+    arenaFreeNode(&ctx->arena, current_state_node);
   }
 
   /* Return -1 indicating no soltion is found: */
+  ctx->stats.closed_set_size = ctx->closed_set.count;
+  astarClearOpenList(&ctx->open_list);
+  arenaReset(&ctx->arena);
   return -1;
 
 }
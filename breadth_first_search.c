@@ -8,7 +8,7 @@
 *
 * PUBLIC FUNCTIONS :
 *
-*       int breadthFirstSearch(int, int, int, int **)
+*       int breadthFirstSearch(SOLVER_CONTEXT *, BOARD *)
 *
 * AUTHOR : Philip Cheng
 * DATE   : 18 October 2017
@@ -19,87 +19,104 @@
 /**
  * Function: breadthFirstSearch
  *
- * Performs a breadth first search on the input <board_state> with the given
- * <board_height>, <board_width>, and <max_block_num> (highest brick value).
+ * Performs a breadth first search on the input <board_state> of the puzzle in
+ * <ctx> (whose queue, arena, path store, and closed set the search uses).
  * If a solution is found, this function will return the path cost from the
  * start state to the goal state along the solution path.  If no solution path
  * is found, this funcion returns -1.
  */
 
-int breadthFirstSearch(int board_height, int board_width, int max_block_num, int **board_state) {
+int breadthFirstSearch(SOLVER_CONTEXT *ctx, BOARD *board_state) {
 
   int i = 0;
   int num_moves = 0;
-  MOVE *available_moves = NULL;
+  MOVE  available_moves[MAX_AVAILABLE_MOVES];
   STATE_NODE* current_state_node = NULL;
 
-  int **next_board_state = NULL;
-  int   next_board_depth = 0;
+  BOARD    next_board_state;
+  STATE_KEY next_board_key;
+  uint64_t current_board_hash = 0;
+  uint64_t next_board_hash = 0;
+  int      next_board_depth = 0;
 
-  char *next_board_hash  = NULL;
   int   hash_table_value = 0;
 
   /* Create Root State Node for the BFS */
   STATE_NODE root_state_node;
   root_state_node.path_cost = 0;
-  root_state_node.board_state = board_state;
-  root_state_node.move_from_parent = NULL;
+  root_state_node.board_state = *board_state;
+  root_state_node.move_from_parent = 0;
   root_state_node.parent = NULL;
   root_state_node.next = NULL;
 
+  /* Start a new Path Store (with the Root State) */
+  root_state_node.path_index = pathStoreReset(&ctx->paths);
+
   /* Enqueue Root Node into BFS FIFO Queue */
-  bfsEnqueue(root_state_node.board_state, NULL, NULL);
+  bfsEnqueue(&ctx->bfs_queue, &ctx->arena, &root_state_node.board_state, 0, root_state_node.path_index);
 
   /* Initialize Hash Table of Visited States (a.k.a. "Closed Set") */
-  initStateHashTable(board_height, board_width, max_block_num);
+  initStateHashTable(&ctx->closed_set, getStateKeyWords(&ctx->keys));
 
   /* Add Root State to the Closed Set */
-  insertIntoStateHashTable(getStateHashKey(board_state), 0);
+  getStateKey(&ctx->keys, &root_state_node.board_state, &next_board_key);
+  insertIntoStateHashTable(&ctx->closed_set, &next_board_key,
+                           getBoardHashKey(ctx, &root_state_node.board_state), 0);
 
   /* Loop through states in FIFO Queue */
-  while(!bfsQueueIsEmpty()) {
+  while(!bfsQueueIsEmpty(&ctx->bfs_queue)) {
 
     /* Dequeue the next State Node */
-    current_state_node = bfsDequeue();
+    current_state_node = bfsDequeue(&ctx->bfs_queue);
 
     /* Generate list of legal moves from Current State */
-    num_moves = getAllAvailableMoves(current_state_node->board_state, &available_moves);
+    num_moves = getAllAvailableMoves(ctx, &current_state_node->board_state, available_moves);
+    countExpandedNode(&ctx->stats, num_moves);
+
+    /* Each move is made in place on one copy of the Current State (with its
+       canonical key and hash updated incrementally), then unmade */
+    next_board_state = current_state_node->board_state;
+    getStateKey(&ctx->keys, &next_board_state, &next_board_key);
+    current_board_hash = getBoardHashKey(ctx, &next_board_state);
+    next_board_depth = current_state_node->path_cost + 1;
 
     for (i = 0; i < num_moves; i++) {
 
-      /* Generate and Normalize Next State */
-      next_board_state = applyMoveCloning(current_state_node->board_state, available_moves[i]);
-      next_board_depth = current_state_node->path_cost + 1;
-      normalizeState(next_board_state);
+      /* Generate Next State */
+      next_board_hash = makeMove(ctx, &next_board_state, available_moves[i], current_board_hash, &next_board_key);
 
       /* Check if goal state is reached */
-      if (checkGameComplete(next_board_state)) {
+      if (checkMoveCompletesGame(ctx, &next_board_state, available_moves[i])) {
 
         /* Print path to goal state (and print the goal state) */
-        printPath(current_state_node);
-        printMove(&available_moves[i]);
-        printState(next_board_state);
-        free(next_board_state);
+        printStoredSolution(ctx, board_state, current_state_node->path_index, available_moves[i]);
+        drainQueue(&ctx->bfs_queue);
+        ctx->stats.closed_set_size = ctx->closed_set.count;
+        arenaReset(&ctx->arena);
         return next_board_depth;
       }
 
       /* Add to FIFO Queue (if not already part of the closed Set) */
-      next_board_hash = getStateHashKey(next_board_state);
-      hash_table_value = getHashTableValue(next_board_hash);
-      if (hash_table_value >= 0) {
-        free(next_board_state);
-        free(next_board_hash);
-      }
-      else
-      {
-        bfsEnqueue(next_board_state, &available_moves[i], current_state_node);
-        insertIntoStateHashTable(next_board_hash, next_board_depth);
+      hash_table_value = getHashTableValue(&ctx->closed_set, &next_board_key, next_board_hash);
+      if (hash_table_value < 0) {
+        bfsEnqueue(&ctx->bfs_queue, &ctx->arena, &next_board_state, next_board_depth,
+                   pathStoreAdd(&ctx->paths, current_state_node->path_index,
+                                encodeMove(&ctx->keys, available_moves[i])));
+        insertIntoStateHashTable(&ctx->closed_set, &next_board_key, next_board_hash, next_board_depth);
       }
 
+      /* Back to the Current State */
+      unmakeMove(ctx, &next_board_state, available_moves[i], next_board_hash, &next_board_key);
+
     }
+
+    /* The Current State is done with (its path is in the Path Store) */
+    arenaFreeNode(&ctx->arena, current_state_node);
   }
 
   /* Return -1 indicating no soltion is found: */
+  ctx->stats.closed_set_size = ctx->closed_set.count;
+  arenaReset(&ctx->arena);
   return -1;
 
 }
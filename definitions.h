@@ -4,9 +4,9 @@
 * DESCRIPTION :
 *
 *       Contains definitions needed for the sliding brick puzzle, including
-*       representations of a Brick Move and State (containing the information
-*       about the board, and the path cost to get to that state).  These State
-*       Nodes are used to create the graphs for BFS and DFS traversal
+*       representations of a Board, a Brick Move and State (containing the
+*       information about the board, and the path cost to get to that state).
+*       These State Nodes are used to create the graphs for BFS and DFS traversal
 *
 * PUBLIC FUNCTIONS :
 *
@@ -21,28 +21,67 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdint.h>
 
 /* Maximum number of chars / block (in input text file) */
 #define MAX_BLOCK_NUM_CHARS 10
 
+/* Maximum number of cells (width x height) and highest block on a board */
+#define MAX_BOARD_CELLS 64
+#define MAX_BLOCK_NUM   127
+
+/* Maximum number of legal moves from any state (4 directions per block) */
+#define MAX_AVAILABLE_MOVES (4 * MAX_BOARD_CELLS)
+
+/* Number of 64-bit words in a packed Board */
+#define BOARD_WORDS (MAX_BOARD_CELLS / 8)
+
+/* Represents a Board: one signed byte per cell (row-major), packed into a
+   few 64-bit words so that copying, comparing, and hashing a board are just
+   a handful of word operations.  Unused cells past width x height are 0. */
+typedef union BOARD {
+    int8_t   cells[MAX_BOARD_CELLS];
+    uint64_t words[BOARD_WORDS];
+} BOARD;
+
+/* Represents the canonical key of a Board: the first cell of every brick, one
+   byte per brick, grouped by shape (see canonical_key.c).  Only the first few
+   words are used, depending on the number of bricks; the rest are unused. */
+typedef union STATE_KEY {
+    uint8_t  anchors[MAX_BOARD_CELLS];
+    uint64_t words[BOARD_WORDS];
+} STATE_KEY;
+
 /* Implements the Block Move Diretion options */
 typedef enum {UP, DOWN, LEFT, RIGHT} Move_Direction;
 const char *Move_Strings[] = {"up","down","left","right"};
 
+/* Row and column steps of each Move Direction, and the direction that undoes it */
+const int            Move_Row_Deltas[]     = {-1, 1, 0, 0};
+const int            Move_Col_Deltas[]     = {0, 0, -1, 1};
+const Move_Direction Opposite_Directions[] = {DOWN, UP, RIGHT, LEFT};
+
 /* Represents a Block Move */
 typedef struct MOVE {
     int            block_num;
     Move_Direction direction;
 } MOVE;
 
-/* State Node for the Breadth First Search (BFS) FIFO Queue and
-   Depth First Search (DFS) FILO Stack.  The State Node is used
-   to create the graph for searching across. */
+/* State Node for the Breadth First Search (BFS) FIFO Queue,
+   Depth First Search (DFS) FILO Stack, and A* Open List.  The State
+   Node is used to create the graph for searching across. */
 
 typedef struct STATE_NODE {
     int    path_cost;          /* Cost from start of puzzle, i.e. g(n)     */
-    int  **board_state;        /* 2-D array of the board contents          */
-    MOVE  *move_from_parent;   /* Move leading to this board_state         */
+    int    heuristic;          /* Cached estimate to the goal, i.e. h(n)   */
+    BOARD  board_state;        /* Packed board contents                    */
+    uint8_t move_from_parent;  /* Move leading to this board_state (packed) */
     struct STATE_NODE *parent; /* parent state leading to this board_state */
+    int    path_index;         /* Index in the search's Path Store         */
     struct STATE_NODE *next;   /* Next pointer (used for FIFO and FILO)    */
 } STATE_NODE;
+
+/* Solver Context: everything about one loaded puzzle and the search running
+   on it, which the game and search functions take explicitly (it is defined
+   in utilities/solver_context.c, once the types of its parts are known) */
+typedef struct SOLVER_CONTEXT SOLVER_CONTEXT;
@@ -6,14 +6,17 @@
 *       Contains implementations for a generalized depth first search (DFS)
 *       to solve the Sliding Brick Puzzle Game.  The general DFS is then used
 *       to create more specifically: (1) a strict DFS function, a Depth-limited
-*       DFS function, and an Iterative Deepening DFS function.
+*       DFS function, and an Iterative Deepening DFS function.  The Iterative
+*       Deepening DFS is the IDA* Search (see ida_star_search.c) with h(n) = 0,
+*       so it searches a single board in place, and keeps what it learns in a
+*       transposition table from one depth to the next.
 *
 * PUBLIC FUNCTIONS :
 *
-*       int generalDepthFirstSearch (int, int, int, int**, bool, int)
-*       int depthFirstSearch (int, int, int, int**)
-*       int depthLimitedSearch (int, int, int, int**, int)
-*       int interativeDeepeningSearch (int, int, int, int**)
+*       int generalDepthFirstSearch (SOLVER_CONTEXT *, BOARD *, bool, int)
+*       int depthFirstSearch (SOLVER_CONTEXT *, BOARD *)
+*       int depthLimitedSearch (SOLVER_CONTEXT *, BOARD *, int)
+*       int interativeDeepeningSearch (SOLVER_CONTEXT *, BOARD *)
 *
 * AUTHOR : Philip Cheng
 * DATE   : 18 October 2017
@@ -24,100 +27,119 @@
 /**
  * Function: generalDepthFirstSearch
  *
- * Performs a depth first search on the input <board_state> with the given
- * <board_height>, <board_width>, and <max_block_num> (highest brick value).
+ * Performs a depth first search on the input <board_state> of the puzzle in
+ * <ctx> (whose stack, arena, path store, and closed set the search uses).
  * If <depth_limited> is set to true, then the search will only search down to
  * a maximum number of steps, <max_depth>.  If a solution is found, this function
  * will return the path cost from the start state to the goal state along the
  * solution path.  If no solution path is found, this funcion returns -1.
  */
 
-int generalDepthFirstSearch(int board_height, int board_width, int max_block_num,
-                            int **board_state, bool depth_limited, int max_depth) {
+int generalDepthFirstSearch(SOLVER_CONTEXT *ctx, BOARD *board_state, bool depth_limited, int max_depth) {
 
   int i = 0;
   int num_moves = 0;
-  MOVE *available_moves = NULL;
+  MOVE  available_moves[MAX_AVAILABLE_MOVES];
   STATE_NODE* current_state_node = NULL;
 
-  int **next_board_state = NULL;
-  int   next_board_depth = 0;
+  BOARD    next_board_state;
+  STATE_KEY next_board_key;
+  uint64_t current_board_hash = 0;
+  uint64_t next_board_hash = 0;
+  int      next_board_depth = 0;
 
-  char *next_board_hash  = NULL;
   int   hash_table_value = 0;
 
   /* Create Root State Node for the DFS */
   STATE_NODE root_state_node;
   root_state_node.path_cost = 0;
-  root_state_node.board_state = board_state;
-  root_state_node.move_from_parent = NULL;
+  root_state_node.board_state = *board_state;
+  root_state_node.move_from_parent = 0;
   root_state_node.parent = NULL;
   root_state_node.next = NULL;
 
+  /* Start a new Path Store (with the Root State) */
+  root_state_node.path_index = pathStoreReset(&ctx->paths);
+
   /* Push Root Node onto DFS FILO Stack */
-  dfsPushStack(root_state_node.board_state, NULL, NULL);
+  dfsPushStack(&ctx->dfs_stack, &ctx->arena, &root_state_node.board_state, 0, root_state_node.path_index);
 
   /* Initialize Hash Table of Visited States (a.k.a. "Closed Set") */
-  initStateHashTable(board_height, board_width, max_block_num);
+  initStateHashTable(&ctx->closed_set, getStateKeyWords(&ctx->keys));
 
   /* Add Root State to the Closed Set */
-  insertIntoStateHashTable(getStateHashKey(board_state), 0);
+  getStateKey(&ctx->keys, &root_state_node.board_state, &next_board_key);
+  insertIntoStateHashTable(&ctx->closed_set, &next_board_key,
+                           getBoardHashKey(ctx, &root_state_node.board_state), 0);
 
   /* Loop through states in FILO Stack */
-  while(!dfsStackIsEmpty()) {
+  while(!dfsStackIsEmpty(&ctx->dfs_stack)) {
 
     /* Dequeue the next State Node */
-    current_state_node = dfsPopStack();
+    current_state_node = dfsPopStack(&ctx->dfs_stack);
 
     /* Apply Check for Depth-Limited Search */
     if (!depth_limited || current_state_node->path_cost < max_depth) {
 
       /* Generate list of legal moves from Current State */
-      num_moves = getAllAvailableMoves(current_state_node->board_state, &available_moves);
+      num_moves = getAllAvailableMoves(ctx, &current_state_node->board_state, available_moves);
+      countExpandedNode(&ctx->stats, num_moves);
+
+      /* Each move is made in place on one copy of the Current State (with its
+         canonical key and hash updated incrementally), then unmade */
+      next_board_state = current_state_node->board_state;
+      getStateKey(&ctx->keys, &next_board_state, &next_board_key);
+      current_board_hash = getBoardHashKey(ctx, &next_board_state);
+      next_board_depth = current_state_node->path_cost + 1;
 
       for (i = 0; i < num_moves; i++) {
 
-        /* Generate and Normalize Next State */
-        next_board_state = applyMoveCloning(current_state_node->board_state, available_moves[i]);
-        next_board_depth = current_state_node->path_cost + 1;
-        normalizeState(next_board_state);
+        /* Generate Next State */
+        next_board_hash = makeMove(ctx, &next_board_state, available_moves[i], current_board_hash,
+                                   &next_board_key);
 
         /* Check if goal state is reached */
-        if (checkGameComplete(next_board_state)) {
+        if (checkMoveCompletesGame(ctx, &next_board_state, available_moves[i])) {
 
           /* Print path to goal state (and print the goal state) */
-          printPath(current_state_node);
-          printMove(&available_moves[i]);
-          printState(next_board_state);
-          free(next_board_state);
+          printStoredSolution(ctx, board_state, current_state_node->path_index, available_moves[i]);
+          drainStack(&ctx->dfs_stack);
+          ctx->stats.closed_set_size = ctx->closed_set.count;
+          arenaReset(&ctx->arena);
           return next_board_depth;
         }
 
         /* Add to FILO Stack (if not already part of the closed Set) */
-        next_board_hash = getStateHashKey(next_board_state);
-        hash_table_value = getHashTableValue(next_board_hash);
+        hash_table_value = getHashTableValue(&ctx->closed_set, &next_board_key, next_board_hash);
 
         if (hash_table_value < 0) {
-          dfsPushStack(next_board_state, &available_moves[i], current_state_node);
-          insertIntoStateHashTable(next_board_hash, next_board_depth);
+          dfsPushStack(&ctx->dfs_stack, &ctx->arena, &next_board_state, next_board_depth,
+                       pathStoreAdd(&ctx->paths, current_state_node->path_index,
+                                    encodeMove(&ctx->keys, available_moves[i])));
+          insertIntoStateHashTable(&ctx->closed_set, &next_board_key, next_board_hash, next_board_depth);
         }
         else if (hash_table_value > next_board_depth)
         {
-          dfsPushStack(next_board_state, &available_moves[i], current_state_node);
-          updateHashTableValue(next_board_hash, next_board_depth);
-          free(next_board_hash);
-        }
-        else
-        {
-          free(next_board_hash);
+          dfsPushStack(&ctx->dfs_stack, &ctx->arena, &next_board_state, next_board_depth,
+                       pathStoreAdd(&ctx->paths, current_state_node->path_index,
+                                    encodeMove(&ctx->keys, available_moves[i])));
+          updateHashTableValue(&ctx->closed_set, &next_board_key, next_board_hash, next_board_depth);
         }
 
+        /* Back to the Current State */
+        unmakeMove(ctx, &next_board_state, available_moves[i], next_board_hash, &next_board_key);
+
       }
     }
 
+    /* The Current State is done with (its path is in the Path Store) */
+    arenaFreeNode(&ctx->arena, current_state_node);
+
   }
 
   /* Return -1 indicating no soltion is found: */
+  ctx->stats.closed_set_size = ctx->closed_set.count;
+  arenaReset(&ctx->arena);
   return -1;
 
 }
@@ -126,55 +148,40 @@ int generalDepthFirstSearch(int board_height, int board_width, int max_block_num
 /**
  * Function: depthFirstSearch
  *
- * Performs an UNLIMITED depth first search on the input <board_state> with the given
- * <board_height>, <board_width>, and <max_block_num> (highest brick value). If a
- * solution is found, this function will return the path cost from the start state to
- * the goal state along the solution path.  If no solution path is found, this
- * function returns -1.
+ * Performs an UNLIMITED depth first search on the input <board_state> of the
+ * puzzle in <ctx>. If a solution is found, this function will return the path
+ * cost from the start state to the goal state along the solution path.  If no
+ * solution path is found, this function returns -1.
  */
 
-int depthFirstSearch(int board_height, int board_width, int max_block_num, int **board_state) {
-  return generalDepthFirstSearch(board_height, board_width, max_block_num, board_state, false, 0);
+int depthFirstSearch(SOLVER_CONTEXT *ctx, BOARD *board_state) {
+  return generalDepthFirstSearch(ctx, board_state, false, 0);
 }
 
 
 /**
  * Function: depthLimitedSearch
  *
- * Performs a DEPTH-LIMITED depth first search on the input <board_state> with the given
- * <board_height>, <board_width>, and <max_block_num> (highest brick value). If a
- * solution is found, this function will return the path cost from the start state to
- * the goal state along the solution path.  If no solution path is found, this
- * function returns -1.
+ * Performs a DEPTH-LIMITED depth first search on the input <board_state> of
+ * the puzzle in <ctx>. If a solution is found, this function will return the
+ * path cost from the start state to the goal state along the solution path.
+ * If no solution path is found, this function returns -1.
  */
 
-int depthLimitedSearch(int board_height, int board_width, int max_block_num, int **board_state, int max_depth) {
-  return generalDepthFirstSearch(board_height, board_width, max_block_num, board_state, true, max_depth);
+int depthLimitedSearch(SOLVER_CONTEXT *ctx, BOARD *board_state, int max_depth) {
+  return generalDepthFirstSearch(ctx, board_state, true, max_depth);
 }
 
 /**
  * Function: interativeDeepeningSearch
  *
  * Performs a series of DEPTH-LIMITED depth first searches on the input <board_state>
- * with the given <board_height>, <board_width>, and <max_block_num> (highest brick
- * value) --  utilizing the iterative deepening seach algorith.  If a solution is found,
- * this function will return the path cost from the start state to the goal state along
- * the solution path.  If no solution path is found, this function returns -1.
+ * of the puzzle in <ctx> --  utilizing the iterative deepening seach algorith.  If a
+ * solution is found, this function will return the path cost from the start state to
+ * the goal state along the solution path.  If no solution path is found, this
+ * function returns -1.
  */
 
-int interativeDeepeningSearch(int board_height, int board_width, int max_block_num, int **board_state) {
-
-  int  search_depth  = 0;
-  int  search_result = 0;
-  bool goal_reached  = false;
-
-  while (!goal_reached) {
-
-    resetHashTable();
-    search_result = depthLimitedSearch(board_height, board_width, max_block_num, board_state, ++search_depth);
-    goal_reached = (search_result > 0);
-
-  }
-
-  return search_depth;
+int interativeDeepeningSearch(SOLVER_CONTEXT *ctx, BOARD *board_state) {
+  return iterativeDeepeningAStar(ctx, board_state, false);
 }
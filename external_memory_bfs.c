@@ -0,0 +1,567 @@
+/************************************************************************
+* FILENAME : external_memory_bfs.c
+*
+* DESCRIPTION :
+*
+*       Contains an implementation of an external-memory breadth first search,
+*       to solve the Sliding Brick Puzzle Game when its state space does not
+*       fit into memory.  No State Nodes or closed set are kept in memory:
+*       each layer of the search is a file of canonical keys (see
+*       canonical_key.c), sorted and without duplicates, and a board is
+*       rebuilt from its key whenever it is expanded.
+*
+*       The successors of a layer are collected in a buffer of a fixed size
+*       (the RAM budget).  Whenever the buffer is full, it is sorted and
+*       written out as a "run" file.  Duplicates are only removed once the
+*       whole layer has been expanded (delayed duplicate detection): the runs
+*       are merged together, and against the current and previous layers,
+*       into the next layer's file.  Since every move can be undone, a
+*       successor of layer d can only be in layers d-1, d, or d+1, so no older
+*       layers are needed.  The layer files are kept until the end, though, so
+*       that the solution path can be found again by walking back through them.
+*
+*       The files are created in a directory given on the command line (and
+*       are deleted as soon as they are created, so nothing is left behind).
+*
+* PUBLIC FUNCTIONS :
+*
+*       int externalBreadthFirstSearch(SOLVER_CONTEXT *, BOARD *, long, char *)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+/* Default RAM budget for the successor buffer, and directory for the files */
+#define EBFS_DEFAULT_MEMORY_MB 64
+#define EBFS_DEFAULT_DIRECTORY "/tmp"
+
+/* Reads one file of sorted keys, one record at a time */
+typedef struct EBFS_READER {
+    FILE   *file;
+    int     record_size;
+    uint8_t record[MAX_BOARD_CELLS];
+    bool    valid;                     /* False once the file is used up */
+} EBFS_READER;
+
+/* State of an External-Memory BFS */
+typedef struct EBFS_SEARCH {
+
+    /* Puzzle being solved, bytes per record (i.e. per key), and directory
+       for the files */
+    SOLVER_CONTEXT *ctx;
+    int             record_size;
+    char           *directory;
+
+    /* Run files written for the layer being expanded */
+    FILE **runs;
+    int    num_runs;
+    int    runs_capacity;
+
+} EBFS_SEARCH;
+
+/* Record size for ebfsCompareRecords (qsort has no argument to pass it in,
+   so it is set by the thread, right before it sorts) */
+static __thread int ebfs_sort_record_size = 0;
+
+
+/**
+ * Function: ebfsCreateFile
+ *
+ * Creates a new (empty) file in the <search>'s directory, for reading and
+ * writing.  The file is unlinked right away, so it goes away once it is closed.
+ */
+
+static FILE *ebfsCreateFile(EBFS_SEARCH *search) {
+
+  char  path[FILENAME_MAX];
+  int   fd = -1;
+  FILE *file = NULL;
+
+  snprintf(path, sizeof(path), "%s/sbp-ebfs-XXXXXX", search->directory);
+  fd = mkstemp(path);
+  if (fd >= 0) {
+    unlink(path);
+    file = fdopen(fd, "w+b");
+  }
+
+  if (file == NULL) {
+    fprintf(stderr, "Could not create a file in %s (external-memory BFS).\n", search->directory);
+    exit(EXIT_FAILURE);
+  }
+
+  return file;
+
+}
+
+
+/**
+ * Function: ebfsWriteRecord
+ *
+ * Appends a <record> to the <file> of the <search>.
+ */
+
+static void ebfsWriteRecord(EBFS_SEARCH *search, FILE *file, uint8_t *record) {
+
+  if (fwrite(record, search->record_size, 1, file) != 1) {
+    fprintf(stderr, "Could not write to %s (external-memory BFS).\n", search->directory);
+    exit(EXIT_FAILURE);
+  }
+
+}
+
+
+/**
+ * Function: ebfsNextRecord
+ *
+ * Reads the next record of the <reader>'s file.
+ */
+
+static void ebfsNextRecord(EBFS_READER *reader) {
+
+  reader->valid = (fread(reader->record, reader->record_size, 1, reader->file) == 1);
+
+}
+
+
+/**
+ * Function: ebfsStartReading
+ *
+ * Starts the <reader> at the first record of the <file> of the <search> (if
+ * <file> is NULL, the reader is simply empty).
+ */
+
+static void ebfsStartReading(EBFS_SEARCH *search, EBFS_READER *reader, FILE *file) {
+
+  reader->file  = file;
+  reader->record_size = search->record_size;
+  reader->valid = false;
+
+  if (file != NULL) {
+    fflush(file);
+    rewind(file);
+    ebfsNextRecord(reader);
+  }
+
+}
+
+
+/**
+ * Function: ebfsCompareRecords
+ *
+ * Compares two records (for sorting, with ebfs_sort_record_size set).
+ */
+
+static int ebfsCompareRecords(const void *record_a, const void *record_b) {
+  return memcmp(record_a, record_b, ebfs_sort_record_size);
+}
+
+
+/**
+ * Function: ebfsWriteRun
+ *
+ * Sorts the <num_records> records in the <buffer>, and writes them (without
+ * duplicates) to a new run file of the <search>, which is returned.
+ */
+
+static FILE *ebfsWriteRun(EBFS_SEARCH *search, uint8_t *buffer, long num_records) {
+
+  long  i = 0;
+  int   size = search->record_size;
+  FILE *run = ebfsCreateFile(search);
+
+  ebfs_sort_record_size = size;
+  qsort(buffer, num_records, size, ebfsCompareRecords);
+
+  for (i = 0; i < num_records; i++) {
+    if (i == 0 || memcmp(&buffer[i * size], &buffer[(i - 1) * size], size) != 0) {
+      ebfsWriteRecord(search, run, &buffer[i * size]);
+    }
+  }
+
+  return run;
+
+}
+
+
+/**
+ * Function: ebfsAddRun
+ *
+ * Adds a <run> file to the runs of the layer being expanded by the <search>.
+ */
+
+static void ebfsAddRun(EBFS_SEARCH *search, FILE *run) {
+
+  if (search->num_runs == search->runs_capacity) {
+    search->runs_capacity = (search->runs_capacity == 0) ? 16 : search->runs_capacity * 2;
+    search->runs = realloc(search->runs, sizeof(FILE *) * search->runs_capacity);
+    if (search->runs == NULL) {
+      fprintf(stderr, "Out of memory (external-memory BFS).\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  search->runs[search->num_runs++] = run;
+
+}
+
+
+/**
+ * Function: ebfsSkipTo
+ *
+ * Advances the <reader> past every record below the <record>, and returns true
+ * if the reader's file has the <record>.
+ */
+
+static bool ebfsSkipTo(EBFS_READER *reader, uint8_t *record) {
+
+  while (reader->valid && memcmp(reader->record, record, reader->record_size) < 0) {
+    ebfsNextRecord(reader);
+  }
+
+  return reader->valid && memcmp(reader->record, record, reader->record_size) == 0;
+
+}
+
+
+/**
+ * Function: ebfsMergeRuns
+ *
+ * Merges the runs of the layer being expanded by the <search> into the
+ * <next_layer> file, leaving out the duplicates, and every record that is in
+ * the <prev_layer> or the <layer>.  Closes the runs, and returns the number of
+ * records in the next layer.
+ */
+
+static long ebfsMergeRuns(EBFS_SEARCH *search, FILE *prev_layer, FILE *layer, FILE *next_layer) {
+
+  int  i = 0;
+  int  num_runs = search->num_runs;
+  int  size = search->record_size;
+  int  min_run = 0;
+  long num_records = 0;
+  uint8_t record[MAX_BOARD_CELLS];
+  EBFS_READER  prev_reader;
+  EBFS_READER  layer_reader;
+  EBFS_READER *run_readers = malloc(sizeof(EBFS_READER) * (num_runs + 1));
+
+  if (run_readers == NULL) {
+    fprintf(stderr, "Out of memory (external-memory BFS).\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (i = 0; i < num_runs; i++) {
+    ebfsStartReading(search, &run_readers[i], search->runs[i]);
+  }
+  ebfsStartReading(search, &prev_reader, prev_layer);
+  ebfsStartReading(search, &layer_reader, layer);
+
+  while (true) {
+
+    /* Take the smallest record of all of the runs */
+    min_run = -1;
+    for (i = 0; i < num_runs; i++) {
+      if (run_readers[i].valid &&
+          (min_run < 0 || memcmp(run_readers[i].record, run_readers[min_run].record, size) < 0)) {
+        min_run = i;
+      }
+    }
+    if (min_run < 0) {
+      break;
+    }
+    memcpy(record, run_readers[min_run].record, size);
+
+    /* Skip it in every run (each run has it at most once) */
+    for (i = 0; i < num_runs; i++) {
+      if (run_readers[i].valid && memcmp(run_readers[i].record, record, size) == 0) {
+        ebfsNextRecord(&run_readers[i]);
+      }
+    }
+
+    /* Keep it, unless it was already in the previous or current layer */
+    if (!ebfsSkipTo(&prev_reader, record) && !ebfsSkipTo(&layer_reader, record)) {
+      ebfsWriteRecord(search, next_layer, record);
+      num_records++;
+    }
+  }
+
+  for (i = 0; i < num_runs; i++) {
+    fclose(search->runs[i]);
+  }
+  search->num_runs = 0;
+  free(run_readers);
+
+  return num_records;
+
+}
+
+
+/**
+ * Function: ebfsFindPredecessor
+ *
+ * Scans the <layer> file of the <search> for a state that is one move away
+ * from the state with the canonical key <key>, and stores its key in
+ * <prev_key>.  Returns false if there is no such state in the layer.
+ */
+
+static bool ebfsFindPredecessor(EBFS_SEARCH *search, FILE *layer, STATE_KEY *key, STATE_KEY *prev_key) {
+
+  int i = 0;
+  int num_moves = 0;
+  MOVE      available_moves[MAX_AVAILABLE_MOVES];
+  uint8_t   neighbors[MAX_AVAILABLE_MOVES][MAX_BOARD_CELLS];
+  BOARD     next_board_state;
+  STATE_KEY next_board_key = *key;
+  EBFS_READER reader;
+  SOLVER_CONTEXT *ctx = search->ctx;
+
+  /* Every move can be undone, so the predecessors are the successors */
+  keyToBoard(&ctx->keys, key, &next_board_state);
+  num_moves = getAllAvailableMoves(ctx, &next_board_state, available_moves);
+  for (i = 0; i < num_moves; i++) {
+    makeMove(ctx, &next_board_state, available_moves[i], 0, &next_board_key);
+    memcpy(neighbors[i], next_board_key.anchors, search->record_size);
+    unmakeMove(ctx, &next_board_state, available_moves[i], 0, &next_board_key);
+  }
+  ebfs_sort_record_size = search->record_size;
+  qsort(neighbors, num_moves, MAX_BOARD_CELLS, ebfsCompareRecords);
+
+  ebfsStartReading(search, &reader, layer);
+  for (i = 0; i < num_moves; i++) {
+    if (ebfsSkipTo(&reader, neighbors[i])) {
+      memset(prev_key, 0, sizeof(STATE_KEY));
+      memcpy(prev_key->anchors, neighbors[i], search->record_size);
+      return true;
+    }
+  }
+
+  return false;
+
+}
+
+
+/**
+ * Function: ebfsPrintSolution
+ *
+ * Prints the <search>'s solution path from the <board_state> to the goal state
+ * with the canonical key <goal_key>, which is <path_cost> moves away.  The path
+ * is found by walking back through the <layers> (one predecessor per layer),
+ * and then replayed on the <board_state>.  If a step of the path cannot be
+ * found (i.e. the layer files do not hold a path), the program fails with an
+ * error, as it does when the files cannot be written.
+ */
+
+static void ebfsPrintSolution(EBFS_SEARCH *search, BOARD *board_state, FILE **layers, int path_cost,
+                              STATE_KEY *goal_key) {
+
+  int i,j = 0;
+  int num_moves = 0;
+  MOVE       available_moves[MAX_AVAILABLE_MOVES];
+  STATE_KEY  next_board_key;
+  STATE_KEY *path_keys = NULL;
+  STATE_NODE *path_node = NULL;
+  STATE_NODE *new_node = NULL;
+  MOVE        new_move;
+  SOLVER_CONTEXT *ctx = search->ctx;
+
+  if (!print_solution) {
+    return;
+  }
+
+  /* Walk back from the goal state, one layer at a time */
+  path_keys = arenaAlloc(&ctx->arena, sizeof(STATE_KEY) * (path_cost + 1));
+  path_keys[path_cost] = *goal_key;
+  for (i = path_cost - 1; i > 0; i--) {
+    if (!ebfsFindPredecessor(search, layers[i], &path_keys[i + 1], &path_keys[i])) {
+      fprintf(stderr, "No predecessor in layer %d of the solution path (external-memory BFS).\n", i);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  /* Root State Node */
+  path_node = arenaAlloc(&ctx->arena, sizeof(STATE_NODE));
+  path_node->board_state = *board_state;
+  path_node->move_from_parent = 0;
+  path_node->parent = NULL;
+  path_node->next = NULL;
+  path_node->path_cost = 0;
+  path_node->heuristic = 0;
+
+  /* Replay the path, finding the move to each state on it */
+  for (i = 1; i <= path_cost; i++) {
+
+    new_node = arenaAlloc(&ctx->arena, sizeof(STATE_NODE));
+    new_node->board_state = path_node->board_state;
+    getStateKey(&ctx->keys, &new_node->board_state, &next_board_key);
+
+    num_moves = getAllAvailableMoves(ctx, &new_node->board_state, available_moves);
+    for (j = 0; j < num_moves; j++) {
+      makeMove(ctx, &new_node->board_state, available_moves[j], 0, &next_board_key);
+      if (memcmp(next_board_key.anchors, path_keys[i].anchors, search->record_size) == 0) {
+        new_move = available_moves[j];
+        break;
+      }
+      unmakeMove(ctx, &new_node->board_state, available_moves[j], 0, &next_board_key);
+    }
+    if (j == num_moves) {
+      fprintf(stderr, "No move to step %d of the solution path (external-memory BFS).\n", i);
+      exit(EXIT_FAILURE);
+    }
+
+    new_node->move_from_parent = encodeMove(&ctx->keys, new_move);
+    new_node->parent = path_node;
+    new_node->next = NULL;
+    new_node->path_cost = i;
+    new_node->heuristic = 0;
+    path_node = new_node;
+  }
+
+  printSolution(ctx, path_node->parent, &new_move, &path_node->board_state);
+
+}
+
+
+/**
+ * Function: externalBreadthFirstSearch
+ *
+ * Performs an external-memory breadth first search on the input <board_state>
+ * of the puzzle in <ctx>, using at most <memory_budget_mb> megabytes for the
+ * successor buffer, and keeping its files in <directory>.  If a solution is found, this
+ * function will return the path cost from the start state to the goal state
+ * along the solution path (the same cost as the BFS).  If no solution path is
+ * found, this funcion returns -1.
+ */
+
+int externalBreadthFirstSearch(SOLVER_CONTEXT *ctx, BOARD *board_state, long memory_budget_mb, char *directory) {
+
+  int  i = 0;
+  int  depth = 0;
+  int  num_moves = 0;
+  int  path_cost = -1;
+  long buffer_capacity = 0;
+  long buffer_count = 0;
+  long layer_count = 1;
+  long total_count = 0;
+  MOVE available_moves[MAX_AVAILABLE_MOVES];
+
+  BOARD     next_board_state;
+  STATE_KEY next_board_key;
+  STATE_KEY goal_key;
+  uint8_t  *buffer = NULL;
+  EBFS_READER reader;
+  EBFS_SEARCH search;
+  FILE    **layers = NULL;
+
+  /* Initialize the Search Parameters, and the successor buffer */
+  search.ctx = ctx;
+  search.record_size = getStateKeyBytes(&ctx->keys);
+  if (search.record_size < 1) {
+    search.record_size = 1;
+  }
+  search.directory = (directory != NULL) ? directory : EBFS_DEFAULT_DIRECTORY;
+  search.runs = NULL;
+  search.num_runs = 0;
+  search.runs_capacity = 0;
+  if (memory_budget_mb <= 0) {
+    memory_budget_mb = EBFS_DEFAULT_MEMORY_MB;
+  }
+
+  buffer_capacity = memory_budget_mb * 1024 * 1024 / search.record_size;
+  buffer = malloc(buffer_capacity * search.record_size);
+  layers = malloc(sizeof(FILE *));
+  if (buffer == NULL || layers == NULL) {
+    fprintf(stderr, "Out of memory (external-memory BFS).\n");
+    exit(EXIT_FAILURE);
+  }
+
+  /* Layer 0: the start state */
+  if (checkGameComplete(ctx, board_state)) {
+    path_cost = 0;
+  }
+  getStateKey(&ctx->keys, board_state, &next_board_key);
+  layers[0] = ebfsCreateFile(&search);
+  ebfsWriteRecord(&search, layers[0], next_board_key.anchors);
+
+  /* Expand one layer at a time, until a goal state is reached */
+  while (path_cost < 0 && layer_count > 0) {
+
+    total_count += layer_count;
+
+    ebfsStartReading(&search, &reader, layers[depth]);
+    while (path_cost < 0 && reader.valid) {
+
+      /* Rebuild the board from its key */
+      memset(&next_board_key, 0, sizeof(STATE_KEY));
+      memcpy(next_board_key.anchors, reader.record, search.record_size);
+      keyToBoard(&ctx->keys, &next_board_key, &next_board_state);
+
+      num_moves = getAllAvailableMoves(ctx, &next_board_state, available_moves);
+      countExpandedNode(&ctx->stats, num_moves);
+
+      for (i = 0; i < num_moves; i++) {
+
+        makeMove(ctx, &next_board_state, available_moves[i], 0, &next_board_key);
+
+        /* Check if goal state is reached */
+        if (checkMoveCompletesGame(ctx, &next_board_state, available_moves[i])) {
+          goal_key = next_board_key;
+          path_cost = depth + 1;
+          break;
+        }
+
+        /* Add to the successor buffer (writing out a run when it is full) */
+        memcpy(&buffer[buffer_count * search.record_size], next_board_key.anchors, search.record_size);
+        if (++buffer_count == buffer_capacity) {
+          ebfsAddRun(&search, ebfsWriteRun(&search, buffer, buffer_count));
+          buffer_count = 0;
+        }
+
+        unmakeMove(ctx, &next_board_state, available_moves[i], 0, &next_board_key);
+      }
+
+      ebfsNextRecord(&reader);
+    }
+
+    if (path_cost >= 0) {
+      break;
+    }
+
+    /* Write out the last run, and merge the runs into the next layer */
+    if (buffer_count > 0 || search.num_runs == 0) {
+      ebfsAddRun(&search, ebfsWriteRun(&search, buffer, buffer_count));
+      buffer_count = 0;
+    }
+
+    layers = realloc(layers, sizeof(FILE *) * (depth + 2));
+    if (layers == NULL) {
+      fprintf(stderr, "Out of memory (external-memory BFS).\n");
+      exit(EXIT_FAILURE);
+    }
+    layers[depth + 1] = ebfsCreateFile(&search);
+    layer_count = ebfsMergeRuns(&search, (depth > 0) ? layers[depth - 1] : NULL, layers[depth],
+                                layers[depth + 1]);
+    depth++;
+
+  }
+
+  /* Print path to goal state (and print the goal state) */
+  if (path_cost > 0) {
+    ebfsPrintSolution(&search, board_state, layers, path_cost, &goal_key);
+  }
+
+  /* Clean Up (and report the number of states written to the layers) */
+  ctx->stats.closed_set_size = (int) total_count;
+  for (i = 0; i <= depth; i++) {
+    fclose(layers[i]);
+  }
+  for (i = 0; i < search.num_runs; i++) {
+    fclose(search.runs[i]);
+  }
+  free(search.runs);
+  free(layers);
+  free(buffer);
+  arenaReset(&ctx->arena);
+
+  return path_cost;
+
+}
@@ -0,0 +1,428 @@
+/************************************************************************
+* FILENAME : hash_distributed_a_star_search.c
+*
+* DESCRIPTION :
+*
+*       Contains an implementation of a multithreaded A* Search, to solve the
+*       Sliding Brick Puzzle Game, known as Hash Distributed A* (HDA*).
+*
+*       Every state is owned by one worker thread, chosen by the top bits of
+*       its Zobrist hash.  Each worker keeps its own Open List (the bucketed
+*       priority queue of the serial A*) and its own part of the closed set,
+*       so neither needs a lock: only the owner of a state ever looks it up.
+*       When a worker expands a state, each successor is sent to its owner,
+*       through the owner's inbox (a lock-free queue that any worker can push
+*       onto, and that only the owner takes from, all at once).  Successors
+*       that a worker owns itself skip the inbox.  The owner drops the
+*       successors it has already reached with a path cost that is no higher,
+*       and pushes the others into its Open List.
+*
+*       Since each worker only expands its own best states, the first goal
+*       state found is not always an optimal one.  So every goal state that a
+*       worker takes in is offered to the search's Search Goal (see
+*       search_goal.c), whose cost then prunes every state with an f(n) that
+*       cannot beat it.  The search is over once no work is left anywhere:
+*       the search counts the states that were sent but not yet taken in, or
+*       taken in but not yet expanded (or dropped).  A worker adds the
+*       successors of a state to the count before sending them, and only then
+*       takes the state itself off, so the count cannot reach zero while any
+*       worker still has work to do.  The best goal state found by then is an
+*       optimal one.
+*
+*       The expanded states are never given back to the arenas, since the
+*       states of every other worker may point to them as their parents, and
+*       the path to the goal state is printed by following those pointers.
+*
+* PUBLIC FUNCTIONS :
+*
+*       int hashDistributedAStarSearch(SOLVER_CONTEXT *, BOARD *, int)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+
+/* Max threads */
+#define HDA_MAX_THREADS 256
+
+/* Inbox of a worker: a lock-free stack of State Nodes (linked through their
+   next pointers), padded to a cache line of its own, since every worker
+   pushes onto it */
+typedef struct HDA_INBOX {
+    STATE_NODE *head;
+    char        padding[64 - sizeof(STATE_NODE *)];
+} HDA_INBOX;
+
+/* State shared by the Worker threads of a search */
+typedef struct HDA_SEARCH {
+
+    /* Puzzle being solved */
+    SOLVER_CONTEXT *ctx;
+
+    /* Workers, and the states sent or open but not yet done with */
+    struct HDA_WORKER *workers;
+    int                num_threads;
+    long               pending;
+
+    /* Best goal state found (its path is kept by the worker that found it) */
+    SEARCH_GOAL goal;
+
+} HDA_SEARCH;
+
+/* Worker thread, with its inbox, its own Open List, closed set part, arena,
+   and counters, and the goal state it found (if any) */
+typedef struct HDA_WORKER {
+    HDA_INBOX        inbox;
+    HDA_SEARCH      *search;
+    pthread_t        thread;
+    int              id;
+    ASTAR_OPEN_LIST  open_list;
+    STATE_HASH_TABLE closed_set;
+    ARENA            arena;
+    long             finished;   /* States done with, not yet taken off pending */
+    STATE_NODE      *goal_node;
+    SEARCH_STATS     stats;
+} HDA_WORKER;
+
+
+/**
+ * Function: hdaOwner
+ *
+ * Returns the worker that owns the state with Zobrist hash <hashkey> (taken
+ * from the top bits, since the closed set uses the bottom ones).
+ */
+
+static inline HDA_WORKER *hdaOwner(HDA_SEARCH *search, uint64_t hashkey) {
+  return &search->workers[((hashkey >> 32) * (uint64_t) search->num_threads) >> 32];
+}
+
+
+/**
+ * Function: hdaSend
+ *
+ * Pushes the State <node> onto the inbox of its <owner> (lock-free, from any
+ * worker).
+ */
+
+static void hdaSend(HDA_WORKER *owner, STATE_NODE *node) {
+
+  STATE_NODE *head = __atomic_load_n(&owner->inbox.head, __ATOMIC_RELAXED);
+
+  do {
+    node->next = head;
+  } while (!__atomic_compare_exchange_n(&owner->inbox.head, &head, node, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+}
+
+
+/**
+ * Function: hdaAccept
+ *
+ * Takes a State <node> that the <worker> owns (with canonical <key> and Zobrist
+ * hash <hashkey>) into its Open List, unless the state was already reached
+ * with a path cost that is no higher, or cannot lead to a better goal state
+ * than the best one found.  Otherwise, the node is given back to the arena,
+ * and counted as finished.  A goal state is offered to the Search Goal (and
+ * kept, if it is the best so far) instead.
+ */
+
+static void hdaAccept(HDA_WORKER *worker, STATE_NODE *node, STATE_KEY *key, uint64_t hashkey) {
+
+  int hash_table_value = 0;
+  MOVE  move_from_parent;
+  SOLVER_CONTEXT *ctx = worker->search->ctx;
+
+  hash_table_value = hashTableGet(&worker->closed_set, key, hashkey);
+  if (hash_table_value >= 0 && hash_table_value <= node->path_cost) {
+    arenaFreeNode(&worker->arena, node);
+    worker->finished++;
+    return;
+  }
+
+  /* Check if goal state is reached (by the move that led here) */
+  if (node->parent != NULL) {
+    move_from_parent = decodeMove(&ctx->keys, node->move_from_parent);
+  }
+  if ((node->parent == NULL) ? checkGameComplete(ctx, &node->board_state) :
+                               checkMoveCompletesGame(ctx, &node->board_state, move_from_parent)) {
+    if (offerSearchGoal(&worker->search->goal, node->path_cost, worker->id)) {
+      worker->goal_node = node;
+    }
+    worker->finished++;
+    return;
+  }
+
+  node->heuristic = get_heuristic(ctx, &node->board_state);
+  if (node->path_cost + node->heuristic >= getSearchGoalCost(&worker->search->goal)) {
+    arenaFreeNode(&worker->arena, node);
+    worker->finished++;
+    return;
+  }
+
+  insertIntoStateHashTable(&worker->closed_set, key, hashkey, node->path_cost);
+  astarPushOpenListNode(&worker->open_list, node);
+
+}
+
+
+/**
+ * Function: hdaReceive
+ *
+ * Takes every State Node sent to the <worker> off its inbox, and accepts each
+ * one (see hdaAccept).
+ */
+
+static void hdaReceive(HDA_WORKER *worker) {
+
+  STATE_NODE *node = NULL;
+  STATE_NODE *next_node = NULL;
+  STATE_KEY   key;
+  SOLVER_CONTEXT *ctx = worker->search->ctx;
+
+  if (__atomic_load_n(&worker->inbox.head, __ATOMIC_RELAXED) == NULL) {
+    return;
+  }
+
+  node = __atomic_exchange_n(&worker->inbox.head, NULL, __ATOMIC_ACQUIRE);
+  while (node != NULL) {
+    next_node = node->next;
+    getStateKey(&ctx->keys, &node->board_state, &key);
+    hdaAccept(worker, node, &key, getBoardHashKey(ctx, &node->board_state));
+    node = next_node;
+  }
+
+}
+
+
+/**
+ * Function: hdaExpand
+ *
+ * Expands the State <node> popped off the <worker>'s Open List, i.e. sends each
+ * of its successors to its owner.
+ */
+
+static void hdaExpand(HDA_WORKER *worker, STATE_NODE *node) {
+
+  int i = 0;
+  int num_moves = 0;
+  int hash_table_value = 0;
+  MOVE  available_moves[MAX_AVAILABLE_MOVES];
+  STATE_NODE *next_node = NULL;
+  HDA_WORKER *owner = NULL;
+  HDA_SEARCH *search = worker->search;
+  SOLVER_CONTEXT *ctx = search->ctx;
+
+  BOARD     next_board_state;
+  STATE_KEY next_board_key;
+  uint64_t  current_board_hash = 0;
+  uint64_t  next_board_hash = 0;
+
+  /* Skip stale Nodes (a shorter path to this state was found later) */
+  getStateKey(&ctx->keys, &node->board_state, &next_board_key);
+  current_board_hash = getBoardHashKey(ctx, &node->board_state);
+  hash_table_value = hashTableGet(&worker->closed_set, &next_board_key, current_board_hash);
+  if (hash_table_value < node->path_cost) {
+    arenaFreeNode(&worker->arena, node);
+    worker->finished++;
+    return;
+  }
+
+  /* Generate list of legal moves from Current State (counting each successor
+     as pending before it is sent) */
+  num_moves = getAllAvailableMoves(ctx, &node->board_state, available_moves);
+  countExpandedNode(&worker->stats, num_moves);
+  __atomic_fetch_add(&search->pending, num_moves, __ATOMIC_RELAXED);
+
+  next_board_state = node->board_state;
+
+  for (i = 0; i < num_moves; i++) {
+
+    /* Generate Next State, and send it to its owner */
+    next_board_hash = makeMove(ctx, &next_board_state, available_moves[i], current_board_hash, &next_board_key);
+
+    next_node = arenaAllocNode(&worker->arena);
+    next_node->board_state = next_board_state;
+    next_node->move_from_parent = encodeMove(&ctx->keys, available_moves[i]);
+    next_node->parent = node;
+    next_node->path_index = 0;
+    next_node->path_cost = node->path_cost + 1;
+    next_node->heuristic = 0;
+
+    owner = hdaOwner(search, next_board_hash);
+    if (owner == worker) {
+      hdaAccept(worker, next_node, &next_board_key, next_board_hash);
+    }
+    else
+    {
+      hdaSend(owner, next_node);
+    }
+
+    /* Back to the Current State */
+    unmakeMove(ctx, &next_board_state, available_moves[i], next_board_hash, &next_board_key);
+
+  }
+
+  /* The Current State is done with (but is kept, as its successors' parent) */
+  worker->finished++;
+
+}
+
+
+/**
+ * Function: hdaWorkerThread
+ *
+ * Main loop of a worker thread: takes in the states sent to it, and expands
+ * its best open state, until no work is left in the search.
+ */
+
+static void *hdaWorkerThread(void *arg) {
+
+  HDA_WORKER *worker = (HDA_WORKER *) arg;
+  HDA_SEARCH *search = worker->search;
+  STATE_NODE *node = NULL;
+
+  while (!searchGoalConfirmed(&search->goal)) {
+
+    hdaReceive(worker);
+
+    /* Select the next State Node (unless none is left that could lead to a
+       better goal state) */
+    node = astarPopOpenList(&worker->open_list);
+    if (node != NULL && node->path_cost + node->heuristic >= getSearchGoalCost(&search->goal)) {
+      worker->finished += worker->open_list.size + 1;
+      astarClearOpenList(&worker->open_list);
+      node = NULL;
+    }
+
+    if (node != NULL) {
+      hdaExpand(worker, node);
+    }
+
+    /* Take the finished states off the count, and stop once it is zero (the
+       best goal state found, if any, is then an optimal one) */
+    if (worker->finished > 0) {
+      __atomic_fetch_sub(&search->pending, worker->finished, __ATOMIC_RELEASE);
+      worker->finished = 0;
+    }
+    if (node == NULL) {
+      if (__atomic_load_n(&search->pending, __ATOMIC_ACQUIRE) == 0) {
+        confirmSearchGoal(&search->goal);
+        break;
+      }
+      sched_yield();
+    }
+  }
+
+  return NULL;
+
+}
+
+
+/**
+ * Function: hashDistributedAStarSearch
+ *
+ * Performs an A* Search with <num_threads> worker threads on the input
+ * <board_state> of the puzzle in <ctx>, each owning the states that hash to it
+ * (see above).  If a solution is found, this function will return the path
+ * cost from the start state to the goal state along the solution path (the
+ * optimal cost, for an admissible heuristic).  If no solution path is found,
+ * this funcion returns -1.
+ */
+
+int hashDistributedAStarSearch(SOLVER_CONTEXT *ctx, BOARD *board_state, int num_threads) {
+
+  int i = 0;
+  int path_cost = -1;
+  MOVE  goal_move;
+  HDA_SEARCH  search;
+  HDA_WORKER *workers = NULL;
+  HDA_WORKER *owner = NULL;
+  STATE_NODE *root_state_node = NULL;
+  STATE_NODE *goal_node = NULL;
+  STATE_KEY   root_key;
+  uint64_t    root_hash = 0;
+
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+  if (num_threads > HDA_MAX_THREADS) {
+    num_threads = HDA_MAX_THREADS;
+  }
+
+  workers = calloc(num_threads, sizeof(HDA_WORKER));
+  if (workers == NULL) {
+    fprintf(stderr, "Out of memory (hash distributed A* search).\n");
+    exit(EXIT_FAILURE);
+  }
+
+  /* Get the Pattern Database for this puzzle (if it is used) */
+  preparePatternDatabase(ctx, board_state);
+
+  /* Initialize the Search, and each Worker's part of the Closed Set */
+  search.ctx = ctx;
+  search.workers = workers;
+  search.num_threads = num_threads;
+  search.pending = 1;
+  initSearchGoal(&search.goal);
+
+  for (i = 0; i < num_threads; i++) {
+    workers[i].search = &search;
+    workers[i].id = i;
+    workers[i].goal_node = NULL;
+    hashTableInit(&workers[i].closed_set, getStateKeyWords(&ctx->keys));
+  }
+
+  /* Give the Root State to its owner (before any Worker starts) */
+  root_state_node = arenaAllocNode(&ctx->arena);
+  root_state_node->board_state = *board_state;
+  root_state_node->move_from_parent = 0;
+  root_state_node->parent = NULL;
+  root_state_node->path_index = 0;
+  root_state_node->path_cost = 0;
+  root_state_node->heuristic = 0;
+
+  getStateKey(&ctx->keys, &root_state_node->board_state, &root_key);
+  root_hash = getBoardHashKey(ctx, &root_state_node->board_state);
+  owner = hdaOwner(&search, root_hash);
+  hdaAccept(owner, root_state_node, &root_key, root_hash);
+
+  /* Run the Worker Threads, until no work is left */
+  for (i = 0; i < num_threads; i++) {
+    pthread_create(&workers[i].thread, NULL, hdaWorkerThread, &workers[i]);
+  }
+  for (i = 0; i < num_threads; i++) {
+    pthread_join(workers[i].thread, NULL);
+  }
+
+  /* Print path to goal state (and print the goal state), as found by the
+     worker with the best goal state */
+  if (search.goal.worker >= 0) {
+    goal_node = workers[search.goal.worker].goal_node;
+    if (goal_node->parent != NULL) {
+      goal_move = decodeMove(&ctx->keys, goal_node->move_from_parent);
+      printSolution(ctx, goal_node->parent, &goal_move, &goal_node->board_state);
+    }
+    path_cost = search.goal.path_cost;
+  }
+  freeSearchGoal(&search.goal);
+
+  /* Clean Up Memory (and report the size of the Closed Set) */
+  ctx->stats.closed_set_size = 0;
+  for (i = 0; i < num_threads; i++) {
+    ctx->stats.closed_set_size += workers[i].closed_set.count;
+    ctx->stats.nodes_expanded  += workers[i].stats.nodes_expanded;
+    ctx->stats.nodes_generated += workers[i].stats.nodes_generated;
+    hashTableFree(&workers[i].closed_set);
+    astarClearOpenList(&workers[i].open_list);
+    arenaRelease(&workers[i].arena);
+  }
+  free(workers);
+  arenaReset(&ctx->arena);
+
+  return path_cost;
+
+}
@@ -0,0 +1,305 @@
+/************************************************************************
+* FILENAME : ida_star_search.c
+*
+* DESCRIPTION :
+*
+*       Contains an implementation of an Iterative Deepening A* Search (IDA*),
+*       to solve the Sliding Brick Puzzle Game.  Each iteration is a depth first
+*       search that cuts off every path whose f(n) = g(n) + h(n) is above the
+*       iteration's threshold, and the next threshold is the smallest f(n) that
+*       was cut off.  With h(n) = 0, this is the Iterative Deepening Search.
+*
+*       The search works on a single board, in place: each move is made (with
+*       makeMove, which also updates the board's canonical key and hash) before
+*       searching below it, and unmade afterwards, so no State Nodes are created
+*       and the memory used is O(depth).  A bounded transposition table (see
+*       transposition_table.c) is kept across all of the iterations.  Within an iteration, it cuts off states that were
+*       already reached with a path cost no larger than the current one.
+*       Across iterations, it remembers the lower bound on each state's distance
+*       to the goal learned by searching below it, which is used in place of a
+*       smaller h(n) in the next iterations.
+*
+* PUBLIC FUNCTIONS :
+*
+*       int iterativeDeepeningAStar(SOLVER_CONTEXT *, BOARD *, bool)
+*       int idaStarSearch(SOLVER_CONTEXT *, BOARD *)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+#include <limits.h>
+
+/* Longest solution path that can be searched, "goal found" and "path too
+   long" results, and "no path" f(n) value */
+#define IDA_MAX_DEPTH 4096
+#define IDA_FOUND     -1
+#define IDA_TOO_DEEP  -2
+#define IDA_INFINITY  INT_MAX
+
+/* State of an IDA* Search (passed down the recursion) */
+typedef struct IDA_SEARCH {
+
+    /* Puzzle being solved, and whether h(n) is used */
+    SOLVER_CONTEXT *ctx;
+    bool            use_heuristic;
+
+    /* Board being searched (in place) and its canonical key, and the moves
+       made to reach it */
+    BOARD     board;
+    STATE_KEY key;
+    MOVE      path[IDA_MAX_DEPTH];
+    int       path_cost;
+
+    /* Transposition Table, and the current iteration */
+    TRANSPOSITION_TABLE table;
+    uint32_t            iteration;
+
+} IDA_SEARCH;
+
+
+/**
+ * Function: idaSearch
+ *
+ * Searches (depth first) below the current board of the <search> (with Zobrist
+ * hash <hashkey>), which was reached with path cost <g>, cutting off paths
+ * with an f(n) above <threshold>.  Returns IDA_FOUND if a goal state was
+ * reached (the moves are left in search->path), or IDA_TOO_DEEP if a path
+ * reached IDA_MAX_DEPTH moves (the search cannot go on, and has proven
+ * nothing).  Otherwise, returns a lower bound on the cost of any solution through this
+ * board, which is above the <threshold> for the paths that were cut off (and
+ * IDA_INFINITY if there is no way to a goal from here at all).
+ */
+
+static int idaSearch(IDA_SEARCH *search, int g, int threshold, uint64_t hashkey) {
+
+  int i = 0;
+  int h = 0;
+  int f = 0;
+  int result = IDA_INFINITY;
+  int child_result = 0;
+  int num_moves = 0;
+  MOVE available_moves[MAX_AVAILABLE_MOVES];
+  uint64_t  child_hashkey = 0;
+  TT_ENTRY *entry = NULL;
+  SOLVER_CONTEXT *ctx = search->ctx;
+
+  /* Check if goal state is reached (by the move that led here) */
+  if ((g == 0) ? checkGameComplete(ctx, &search->board) :
+                 checkMoveCompletesGame(ctx, &search->board, search->path[g - 1])) {
+    if (g <= threshold) {
+      search->path_cost = g;
+      return IDA_FOUND;
+    }
+    return g;
+  }
+
+  /* Get h(n), or the better lower bound learned by an earlier search below
+     this state */
+  entry = ttProbe(&search->table, hashkey);
+
+  if (search->use_heuristic) {
+    h = get_heuristic(ctx, &search->board);
+  }
+  if (entry != NULL && entry->h > h) {
+    h = entry->h;
+  }
+
+  /* Cut off paths above the threshold */
+  f = (h >= TT_MAX_VALUE) ? IDA_INFINITY : g + h;
+  if (f > threshold) {
+    return f;
+  }
+
+  /* Cut off states already searched in this iteration with a lower g(n) */
+  if (entry != NULL && entry->iteration == search->iteration && entry->g <= g) {
+    return f;
+  }
+
+  /* No room in the path for another move */
+  if (g >= IDA_MAX_DEPTH) {
+    return IDA_TOO_DEEP;
+  }
+
+  entry = ttStore(&search->table, hashkey);
+  entry->g = g;
+  entry->iteration = search->iteration;
+
+  /* Make each move, search below it, and unmake it */
+  num_moves = getAllAvailableMoves(ctx, &search->board, available_moves);
+  countExpandedNode(&ctx->stats, num_moves);
+
+  for (i = 0; i < num_moves; i++) {
+
+    child_hashkey = makeMove(ctx, &search->board, available_moves[i], hashkey, &search->key);
+    search->path[g] = available_moves[i];
+    child_result = idaSearch(search, g + 1, threshold, child_hashkey);
+    unmakeMove(ctx, &search->board, available_moves[i], child_hashkey, &search->key);
+
+    if (child_result == IDA_FOUND || child_result == IDA_TOO_DEEP) {
+      return child_result;
+    }
+    if (child_result < result) {
+      result = child_result;
+    }
+  }
+
+  /* Remember the lower bound learned for this state (its entry may have
+     been replaced by a state below it) */
+  entry = ttStore(&search->table, hashkey);
+  if (entry->iteration != search->iteration) {
+    entry->g = g;
+    entry->iteration = search->iteration;
+  }
+  if (result == IDA_INFINITY || result - g > TT_MAX_VALUE) {
+    entry->h = TT_MAX_VALUE;
+  }
+  else if (result - g > entry->h)
+  {
+    entry->h = result - g;
+  }
+
+  return result;
+
+}
+
+
+/**
+ * Function: idaPrintSolution
+ *
+ * Prints the solution <path> (of <path_cost> moves, starting from the
+ * <board_state> of the puzzle in <ctx>), and prints the goal state.
+ */
+
+static void idaPrintSolution(SOLVER_CONTEXT *ctx, BOARD *board_state, MOVE *path, int path_cost) {
+
+  int i = 0;
+  STATE_NODE *path_node = NULL;
+  STATE_NODE *new_node  = NULL;
+
+  if (!print_solution || path_cost == 0) {
+    return;
+  }
+
+  /* Root State Node */
+  path_node = arenaAlloc(&ctx->arena, sizeof(STATE_NODE));
+  path_node->board_state = *board_state;
+  path_node->move_from_parent = 0;
+  path_node->parent = NULL;
+  path_node->next = NULL;
+  path_node->path_cost = 0;
+  path_node->heuristic = 0;
+
+  /* Replay the moves */
+  for (i = 0; i < path_cost; i++) {
+    new_node = arenaAlloc(&ctx->arena, sizeof(STATE_NODE));
+    new_node->board_state = path_node->board_state;
+    applyMove(ctx, &new_node->board_state, path[i]);
+    new_node->move_from_parent = encodeMove(&ctx->keys, path[i]);
+    new_node->parent = path_node;
+    new_node->next = NULL;
+    new_node->path_cost = i + 1;
+    new_node->heuristic = 0;
+    path_node = new_node;
+  }
+
+  printSolution(ctx, path_node->parent, &path[path_cost - 1], &path_node->board_state);
+
+}
+
+
+/**
+ * Function: iterativeDeepeningAStar
+ *
+ * Performs an IDA* Search on the input <board_state> of the puzzle in <ctx>.
+ * If <use_heuristic> is false, h(n) = 0 (i.e. Iterative Deepening Search).  If a
+ * solution is found, this function will return the path cost from the start
+ * state to the goal state along the solution path.  If no solution path is
+ * found (or the search had to stop at IDA_MAX_DEPTH moves), this funcion
+ * returns -1.
+ */
+
+int iterativeDeepeningAStar(SOLVER_CONTEXT *ctx, BOARD *board_state, bool use_heuristic) {
+
+  int threshold = 0;
+  int result = 0;
+  int path_cost = 0;
+  BOARD    root_board = *board_state;
+  uint64_t root_hashkey = 0;
+  IDA_SEARCH *search = NULL;
+
+  /* The search state holds a whole path, so it is not kept on the stack */
+  search = calloc(1, sizeof(IDA_SEARCH));
+  if (search == NULL) {
+    fprintf(stderr, "Out of memory (IDA* search).\n");
+    exit(EXIT_FAILURE);
+  }
+
+  /* Initialize the Search, and the Transposition Table */
+  search->ctx = ctx;
+  search->use_heuristic = use_heuristic;
+  ttInit(&search->table, TT_DEFAULT_SIZE_BITS);
+
+  root_hashkey = getBoardHashKey(ctx, &root_board);
+  search->board = root_board;
+  getStateKey(&ctx->keys, &search->board, &search->key);
+  search->path_cost = -1;
+  search->iteration = 0;
+
+  /* Get the Pattern Database for this puzzle (if it is used) */
+  if (use_heuristic) {
+    preparePatternDatabase(ctx, board_state);
+  }
+
+  if (use_heuristic && !checkGameComplete(ctx, board_state)) {
+    threshold = get_heuristic(ctx, board_state);
+  }
+
+  /* Search with larger and larger thresholds, until a goal is reached */
+  while (threshold != IDA_INFINITY) {
+
+    search->iteration++;
+    result = idaSearch(search, 0, threshold, root_hashkey);
+    if (result == IDA_FOUND) {
+      break;
+    }
+    if (result == IDA_TOO_DEEP) {
+      fprintf(stderr, "IDA* search stopped: paths longer than %d moves cannot be searched.\n", IDA_MAX_DEPTH);
+      break;
+    }
+
+    /* The iteration proves there is no solution within the threshold */
+    threshold = (result > threshold + 1) ? result : threshold + 1;
+    if (result == IDA_INFINITY) {
+      threshold = IDA_INFINITY;
+    }
+  }
+
+  /* Print path to goal state (and print the goal state) */
+  if (search->path_cost >= 0) {
+    idaPrintSolution(ctx, &root_board, search->path, search->path_cost);
+  }
+
+  /* Clean Up Memory (and report the number of states in the table) */
+  path_cost = search->path_cost;
+  ctx->stats.closed_set_size = search->table.count;
+  ttFree(&search->table);
+  free(search);
+  arenaReset(&ctx->arena);
+
+  return path_cost;
+
+}
+
+
+/**
+ * Function: idaStarSearch
+ *
+ * Performs an IDA* Search on the input <board_state>, using the same h(n) as
+ * the A* Search.  Returns the path cost of the solution, or -1.
+ */
+
+int idaStarSearch(SOLVER_CONTEXT *ctx, BOARD *board_state) {
+  return iterativeDeepeningAStar(ctx, board_state, true);
+}
@@ -0,0 +1,388 @@
+/************************************************************************
+* FILENAME : parallel_breadth_first_search.c
+*
+* DESCRIPTION :
+*
+*       Contains an implementation of a multithreaded, level-synchronous
+*       breadth first search (BFS), to solve the Sliding Brick Puzzle Game.
+*
+*       The search expands one depth layer (the "frontier") at a time.  The
+*       nodes of the current frontier are handed out to N worker threads in
+*       small chunks, and each worker collects the new states it generates in
+*       its own next-frontier buffer (allocating them from its own arena).  The
+*       closed set is split into PBFS_NUM_SHARDS hash tables, each with its own
+*       lock, chosen by the top bits of the state's Zobrist hash.  Once every
+*       worker has finished the layer, the buffers are joined into the next
+*       frontier.  Since every state in a layer has the same path cost, the
+*       first goal state found is an optimal one, just like the serial BFS.
+*       The worker that finds it keeps its path, and confirms it through the
+*       search's Search Goal (see search_goal.c), which every worker checks
+*       before each node, so the others stop within a node of it.
+*
+*       The shared state of a search is kept in a PBFS_SEARCH, which every
+*       worker points to, and the workers share the (read-only) puzzle of the
+*       Solver Context.
+*
+* PUBLIC FUNCTIONS :
+*
+*       int parallelBreadthFirstSearch(SOLVER_CONTEXT *, BOARD *, int)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+#include <pthread.h>
+
+/* Number of closed set shards, frontier nodes per chunk, and max threads */
+#define PBFS_NUM_SHARDS_BITS 6
+#define PBFS_NUM_SHARDS      (1 << PBFS_NUM_SHARDS_BITS)
+#define PBFS_CHUNK_SIZE      64
+#define PBFS_MAX_THREADS     256
+
+/* Shard of the closed set */
+typedef struct PBFS_SHARD {
+    pthread_mutex_t  lock;
+    STATE_HASH_TABLE table;
+} PBFS_SHARD;
+
+/* State shared by the Worker threads of a search */
+typedef struct PBFS_SEARCH {
+
+    /* Puzzle being solved */
+    SOLVER_CONTEXT *ctx;
+
+    /* Closed Set shards */
+    PBFS_SHARD visited[PBFS_NUM_SHARDS];
+
+    /* Current frontier, and the index of the next chunk to hand out */
+    STATE_NODE **frontier;
+    int          frontier_count;
+    int          next_index;
+
+    /* Layer synchronization (the main thread takes part in both barriers) */
+    pthread_barrier_t start_barrier;
+    pthread_barrier_t end_barrier;
+    bool              done;
+
+    /* Best goal state found (its path is kept by the worker that found it) */
+    SEARCH_GOAL goal;
+
+} PBFS_SEARCH;
+
+/* Worker thread, with its own arena, next-frontier buffer, counters, and
+   the goal state it found (if any) */
+typedef struct PBFS_WORKER {
+    PBFS_SEARCH *search;
+    pthread_t    thread;
+    int          id;
+    ARENA        arena;
+    STATE_NODE **next_frontier;
+    int          next_count;
+    int          next_capacity;
+    SEARCH_STATS stats;
+    STATE_NODE  *goal_parent;
+    MOVE         goal_move;
+    BOARD        goal_board;
+} PBFS_WORKER;
+
+
+/**
+ * Function: pbfsAddToNextFrontier
+ *
+ * Creates a State Node (in the <worker>'s arena) with a copy of the given
+ * information, and appends it to the <worker>'s next-frontier buffer.
+ */
+
+static void pbfsAddToNextFrontier(PBFS_WORKER *worker, BOARD *board_state, MOVE input_move, STATE_NODE *parent) {
+
+  STATE_NODE *new_node = arenaAlloc(&worker->arena, sizeof(STATE_NODE));
+  new_node->board_state = *board_state;
+  new_node->move_from_parent = encodeMove(&worker->search->ctx->keys, input_move);
+  new_node->parent = parent;
+  new_node->heuristic = 0;
+  new_node->next = NULL;
+  new_node->path_cost = parent->path_cost + 1;
+
+  /* Grow the buffer (if full) */
+  if (worker->next_count == worker->next_capacity) {
+    worker->next_capacity = (worker->next_capacity > 0) ? worker->next_capacity * 2 : 1024;
+    worker->next_frontier = realloc(worker->next_frontier, sizeof(STATE_NODE *) * worker->next_capacity);
+    if (worker->next_frontier == NULL) {
+      fprintf(stderr, "Out of memory (parallel BFS).\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  worker->next_frontier[worker->next_count++] = new_node;
+
+}
+
+
+/**
+ * Function: pbfsExpandLayer
+ *
+ * Takes chunks of the current frontier until none are left (or a goal state
+ * is found), and expands every State Node in each chunk.
+ */
+
+static void pbfsExpandLayer(PBFS_WORKER *worker) {
+
+  int i = 0;
+  int start = 0;
+  int end = 0;
+  int num_moves = 0;
+  MOVE  available_moves[MAX_AVAILABLE_MOVES];
+  STATE_NODE *current_state_node = NULL;
+
+  BOARD    next_board_state;
+  STATE_KEY next_board_key;
+  uint64_t current_board_hash = 0;
+  uint64_t next_board_hash = 0;
+  int      hash_table_value = 0;
+  PBFS_SHARD *shard = NULL;
+  PBFS_SEARCH *search = worker->search;
+  SOLVER_CONTEXT *ctx = search->ctx;
+
+  while (!searchGoalConfirmed(&search->goal)) {
+
+    /* Grab the next chunk of the frontier */
+    start = __atomic_fetch_add(&search->next_index, PBFS_CHUNK_SIZE, __ATOMIC_RELAXED);
+    if (start >= search->frontier_count) {
+      return;
+    }
+    end = start + PBFS_CHUNK_SIZE;
+    if (end > search->frontier_count) {
+      end = search->frontier_count;
+    }
+
+    for (; start < end && !searchGoalConfirmed(&search->goal); start++) {
+
+      current_state_node = search->frontier[start];
+
+      /* Generate list of legal moves from Current State */
+      num_moves = getAllAvailableMoves(ctx, &current_state_node->board_state, available_moves);
+      worker->stats.nodes_expanded++;
+      worker->stats.nodes_generated += num_moves;
+
+      /* Each move is made in place on one copy of the Current State (with its
+         canonical key and hash updated incrementally), then unmade */
+      next_board_state = current_state_node->board_state;
+      getStateKey(&ctx->keys, &next_board_state, &next_board_key);
+      current_board_hash = getBoardHashKey(ctx, &next_board_state);
+
+      for (i = 0; i < num_moves; i++) {
+
+        /* Generate Next State */
+        next_board_hash = makeMove(ctx, &next_board_state, available_moves[i], current_board_hash,
+                                   &next_board_key);
+
+        /* Check if goal state is reached (every goal state in this layer is
+           optimal, so the first one is kept, and the search is stopped) */
+        if (checkMoveCompletesGame(ctx, &next_board_state, available_moves[i])) {
+          if (offerSearchGoal(&search->goal, current_state_node->path_cost + 1, worker->id)) {
+            worker->goal_parent = current_state_node;
+            worker->goal_move   = available_moves[i];
+            worker->goal_board  = next_board_state;
+          }
+          confirmSearchGoal(&search->goal);
+          return;
+        }
+
+        /* Add to the Next Frontier (if not already part of the closed Set) */
+        shard = &search->visited[next_board_hash >> (64 - PBFS_NUM_SHARDS_BITS)];
+
+        pthread_mutex_lock(&shard->lock);
+        hash_table_value = hashTableInsertIfAbsent(&shard->table, &next_board_key, next_board_hash,
+                                                   current_state_node->path_cost + 1);
+        pthread_mutex_unlock(&shard->lock);
+
+        if (hash_table_value < 0) {
+          pbfsAddToNextFrontier(worker, &next_board_state, available_moves[i], current_state_node);
+        }
+
+        /* Back to the Current State */
+        unmakeMove(ctx, &next_board_state, available_moves[i], next_board_hash, &next_board_key);
+
+      }
+    }
+  }
+
+}
+
+
+/**
+ * Function: pbfsWorkerThread
+ *
+ * Main loop of a worker thread: waits for a layer to start, expands its share
+ * of the layer, and waits for every other worker to finish the layer.
+ */
+
+static void *pbfsWorkerThread(void *arg) {
+
+  PBFS_WORKER *worker = (PBFS_WORKER *) arg;
+
+  while (true) {
+
+    pthread_barrier_wait(&worker->search->start_barrier);
+    if (worker->search->done) {
+      break;
+    }
+
+    pbfsExpandLayer(worker);
+    pthread_barrier_wait(&worker->search->end_barrier);
+
+  }
+
+  return NULL;
+
+}
+
+
+/**
+ * Function: parallelBreadthFirstSearch
+ *
+ * Performs a level-synchronous breadth first search with <num_threads> worker
+ * threads on the input <board_state> of the puzzle in <ctx>.  If a solution is
+ * found, this function will return the path cost from the start state to the
+ * goal state along the solution path (the same cost as the serial BFS).  If no
+ * solution path is found, this funcion returns -1.
+ */
+
+int parallelBreadthFirstSearch(SOLVER_CONTEXT *ctx, BOARD *board_state, int num_threads) {
+
+  int i,j = 0;
+  int next_frontier_count = 0;
+  int path_cost = -1;
+  PBFS_SEARCH search;
+  PBFS_WORKER workers[PBFS_MAX_THREADS];
+  PBFS_WORKER *worker = NULL;
+  STATE_NODE *root_state_node = NULL;
+  STATE_KEY root_key;
+  uint64_t  root_hash = 0;
+
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+  if (num_threads > PBFS_MAX_THREADS) {
+    num_threads = PBFS_MAX_THREADS;
+  }
+
+  /* Initialize the Closed Set shards */
+  search.ctx = ctx;
+  for (i = 0; i < PBFS_NUM_SHARDS; i++) {
+    pthread_mutex_init(&search.visited[i].lock, NULL);
+    hashTableInit(&search.visited[i].table, getStateKeyWords(&ctx->keys));
+  }
+
+  /* Create Root State Node, and add Root State to the Closed Set */
+  root_state_node = arenaAlloc(&ctx->arena, sizeof(STATE_NODE));
+  root_state_node->path_cost = 0;
+  root_state_node->heuristic = 0;
+  root_state_node->board_state = *board_state;
+  root_state_node->move_from_parent = 0;
+  root_state_node->parent = NULL;
+  root_state_node->next = NULL;
+
+  getStateKey(&ctx->keys, &root_state_node->board_state, &root_key);
+  root_hash = getBoardHashKey(ctx, &root_state_node->board_state);
+  hashTableInsertIfAbsent(&search.visited[root_hash >> (64 - PBFS_NUM_SHARDS_BITS)].table,
+                          &root_key, root_hash, 0);
+
+  search.frontier = malloc(sizeof(STATE_NODE *));
+  if (search.frontier == NULL) {
+    fprintf(stderr, "Out of memory (parallel BFS).\n");
+    exit(EXIT_FAILURE);
+  }
+  search.frontier[0] = root_state_node;
+  search.frontier_count = 1;
+  search.done = false;
+  initSearchGoal(&search.goal);
+
+  /* Start the Worker Threads */
+  pthread_barrier_init(&search.start_barrier, NULL, num_threads + 1);
+  pthread_barrier_init(&search.end_barrier, NULL, num_threads + 1);
+  for (i = 0; i < num_threads; i++) {
+    workers[i].search = &search;
+    workers[i].id = i;
+    workers[i].arena.blocks = NULL;
+    workers[i].arena.free_blocks = NULL;
+    workers[i].arena.free_nodes = NULL;
+    workers[i].next_frontier = NULL;
+    workers[i].next_count = 0;
+    workers[i].next_capacity = 0;
+    workers[i].stats.nodes_expanded = 0;
+    workers[i].stats.nodes_generated = 0;
+    pthread_create(&workers[i].thread, NULL, pbfsWorkerThread, &workers[i]);
+  }
+
+  /* Expand one layer at a time, until a goal is found or the frontier is empty */
+  while (search.frontier_count > 0) {
+
+    search.next_index = 0;
+    pthread_barrier_wait(&search.start_barrier);
+    pthread_barrier_wait(&search.end_barrier);
+
+    if (searchGoalConfirmed(&search.goal)) {
+      break;
+    }
+
+    /* Join the Workers' buffers into the Next Frontier */
+    next_frontier_count = 0;
+    for (i = 0; i < num_threads; i++) {
+      next_frontier_count += workers[i].next_count;
+    }
+
+    free(search.frontier);
+    search.frontier = malloc(sizeof(STATE_NODE *) * (next_frontier_count + 1));
+    if (search.frontier == NULL) {
+      fprintf(stderr, "Out of memory (parallel BFS).\n");
+      exit(EXIT_FAILURE);
+    }
+    search.frontier_count = 0;
+    for (i = 0; i < num_threads; i++) {
+      for (j = 0; j < workers[i].next_count; j++) {
+        search.frontier[search.frontier_count++] = workers[i].next_frontier[j];
+      }
+      workers[i].next_count = 0;
+    }
+
+  }
+
+  /* Stop the Worker Threads */
+  search.done = true;
+  pthread_barrier_wait(&search.start_barrier);
+  for (i = 0; i < num_threads; i++) {
+    pthread_join(workers[i].thread, NULL);
+  }
+  pthread_barrier_destroy(&search.start_barrier);
+  pthread_barrier_destroy(&search.end_barrier);
+
+  /* Print path to goal state (and print the goal state), as found by the
+     worker with the best goal state */
+  if (search.goal.worker >= 0) {
+    worker = &workers[search.goal.worker];
+    printSolution(ctx, worker->goal_parent, &worker->goal_move, &worker->goal_board);
+    path_cost = search.goal.path_cost;
+  }
+  freeSearchGoal(&search.goal);
+
+  /* Clean Up Memory (and report the size of the Closed Set) */
+  ctx->stats.closed_set_size = 0;
+  for (i = 0; i < PBFS_NUM_SHARDS; i++) {
+    ctx->stats.closed_set_size += search.visited[i].table.count;
+    hashTableFree(&search.visited[i].table);
+    pthread_mutex_destroy(&search.visited[i].lock);
+  }
+  for (i = 0; i < num_threads; i++) {
+    ctx->stats.nodes_expanded  += workers[i].stats.nodes_expanded;
+    ctx->stats.nodes_generated += workers[i].stats.nodes_generated;
+    arenaRelease(&workers[i].arena);
+    free(workers[i].next_frontier);
+  }
+  free(search.frontier);
+  arenaReset(&ctx->arena);
+
+  return path_cost;
+
+}
@@ -0,0 +1,621 @@
+/************************************************************************
+* FILENAME : parallel_ida_star_search.c
+*
+* DESCRIPTION :
+*
+*       Contains an implementation of a multithreaded Iterative Deepening A*
+*       Search (IDA*), to solve the Sliding Brick Puzzle Game.  With h(n) = 0,
+*       this is the multithreaded Iterative Deepening Search.
+*
+*       Each iteration is split into Work Items: subtrees of the search, each
+*       given by the moves that lead from the start state to its root.  Every
+*       worker thread has its own deque of Work Items.  Above depth
+*       PIDA_SPLIT_DEPTH, a worker that expands a state does not search below
+*       it, but pushes a Work Item for each of its moves onto its own deque;
+*       below that depth, it searches the subtree itself, depth first and in
+*       place, just like the serial IDA*.  A worker takes its next Work Item
+*       from the back of its own deque (the deepest one, so it stays depth
+*       first), and once that is empty, steals one from the front of another
+*       worker's deque (the shallowest one, i.e. the biggest subtree).  The
+*       iteration is over once every Work Item has been searched.
+*
+*       The workers share one Transposition Table (see the Shared
+*       Transposition Table in transposition_table.c), which is lossy and
+*       lock-free, and cuts off states already searched in this iteration
+*       with a lower g(n), and remembers the lower bounds learned below each
+*       state, just like the table of the serial IDA*.  Every solution found
+*       in an iteration has the cost of its threshold, i.e. is optimal, so
+*       the worker that finds one keeps its path and confirms it through the
+*       search's Search Goal (see search_goal.c), which stops the others.
+*
+* PUBLIC FUNCTIONS :
+*
+*       int parallelIterativeDeepeningAStar(SOLVER_CONTEXT *, BOARD *, bool, int)
+*       int parallelIdaStarSearch(SOLVER_CONTEXT *, BOARD *, int)
+*       int parallelIterativeDeepeningSearch(SOLVER_CONTEXT *, BOARD *, int)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+
+/* Depth above which subtrees are handed out as Work Items, initial Work Items
+   per deque, and max threads */
+#define PIDA_SPLIT_DEPTH   6
+#define PIDA_DEQUE_SIZE    256
+#define PIDA_MAX_THREADS   256
+
+/* Work Item: the subtree below the state reached with these <g> moves */
+typedef struct PIDA_ITEM {
+    int  g;
+    MOVE path[PIDA_SPLIT_DEPTH];
+} PIDA_ITEM;
+
+/* Deque of Work Items: the owner works at the back (tail), and thieves take
+   from the front (head) */
+typedef struct PIDA_DEQUE {
+    pthread_mutex_t lock;
+    PIDA_ITEM      *items;
+    int             head;
+    int             tail;
+    int             capacity;
+} PIDA_DEQUE;
+
+/* State shared by the Worker threads of a search */
+typedef struct PIDA_SEARCH {
+
+    /* Puzzle being solved, whether h(n) is used, and the start state */
+    SOLVER_CONTEXT *ctx;
+    bool            use_heuristic;
+    BOARD           root_board;
+    STATE_KEY       root_key;
+    uint64_t        root_hashkey;
+
+    /* Shared Transposition Table, and the current iteration and threshold */
+    SHARED_TRANSPOSITION_TABLE table;
+    uint32_t                   iteration;
+    int                        threshold;
+
+    /* Workers, and the Work Items pushed but not yet searched */
+    struct PIDA_WORKER *workers;
+    int                 num_threads;
+    int                 pending;
+
+    /* Iteration synchronization (the main thread takes part in both barriers) */
+    pthread_barrier_t start_barrier;
+    pthread_barrier_t end_barrier;
+    bool              done;
+
+    /* Best goal state found (its path is kept by the worker that found it),
+       and whether a path reached IDA_MAX_DEPTH (which stops the search) */
+    SEARCH_GOAL goal;
+    bool        too_deep;
+
+} PIDA_SEARCH;
+
+/* Worker thread, with its own deque, the board it searches in place (and the
+   moves made to reach it), and counters */
+typedef struct PIDA_WORKER {
+    PIDA_SEARCH *search;
+    pthread_t    thread;
+    int          id;
+    PIDA_DEQUE   deque;
+    BOARD        board;
+    STATE_KEY    key;
+    MOVE         path[IDA_MAX_DEPTH];
+    int          path_cost;       /* Cost of the goal state it found (or -1)   */
+    int          next_threshold;  /* Smallest f(n) it cut off this iteration   */
+    SEARCH_STATS stats;
+} PIDA_WORKER;
+
+
+/**
+ * Function: pidaPushItem
+ *
+ * Pushes a copy of the Work <item> onto the back of the <worker>'s deque.
+ */
+
+static void pidaPushItem(PIDA_WORKER *worker, PIDA_ITEM *item) {
+
+  PIDA_DEQUE *deque = &worker->deque;
+
+  __atomic_fetch_add(&worker->search->pending, 1, __ATOMIC_RELAXED);
+
+  pthread_mutex_lock(&deque->lock);
+
+  /* Make room (moving the items to the front, or growing the deque) */
+  if (deque->tail == deque->capacity) {
+    if (deque->head > 0) {
+      memmove(deque->items, &deque->items[deque->head], sizeof(PIDA_ITEM) * (deque->tail - deque->head));
+      deque->tail -= deque->head;
+      deque->head  = 0;
+    }
+    else
+    {
+      deque->capacity *= 2;
+      deque->items = realloc(deque->items, sizeof(PIDA_ITEM) * deque->capacity);
+      if (deque->items == NULL) {
+        fprintf(stderr, "Out of memory (parallel IDA* search).\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+
+  deque->items[deque->tail++] = *item;
+
+  pthread_mutex_unlock(&deque->lock);
+
+}
+
+
+/**
+ * Function: pidaTakeItem
+ *
+ * Takes a Work Item off the <deque> into <item>: from the back if <steal> is
+ * false (the owner), or from the front if it is true (a thief).  Returns false
+ * if the deque is empty.
+ */
+
+static bool pidaTakeItem(PIDA_DEQUE *deque, PIDA_ITEM *item, bool steal) {
+
+  bool taken = false;
+
+  pthread_mutex_lock(&deque->lock);
+  if (deque->head < deque->tail) {
+    *item = steal ? deque->items[deque->head++] : deque->items[--deque->tail];
+    if (deque->head == deque->tail) {
+      deque->head = 0;
+      deque->tail = 0;
+    }
+    taken = true;
+  }
+  pthread_mutex_unlock(&deque->lock);
+
+  return taken;
+
+}
+
+
+/**
+ * Function: pidaSearch
+ *
+ * Searches (depth first) below the current board of the <worker> (with Zobrist
+ * hash <hashkey>), which was reached with path cost <g>, cutting off paths
+ * with an f(n) above <threshold>.  Above PIDA_SPLIT_DEPTH, the subtrees below
+ * the board are pushed as Work Items instead of being searched.  Returns
+ * IDA_FOUND if a goal state was reached (the moves are left in worker->path),
+ * or IDA_TOO_DEEP if a path reached IDA_MAX_DEPTH moves (in any worker).
+ * Otherwise, returns a lower bound on the cost of any solution through this
+ * board, as found by this call (see idaSearch).
+ */
+
+static int pidaSearch(PIDA_WORKER *worker, int g, int threshold, uint64_t hashkey) {
+
+  int i = 0;
+  int h = 0;
+  int f = 0;
+  int result = IDA_INFINITY;
+  int child_result = 0;
+  int num_moves = 0;
+  bool     in_table = false;
+  MOVE     available_moves[MAX_AVAILABLE_MOVES];
+  uint64_t child_hashkey = 0;
+  TT_ENTRY  entry;
+  PIDA_ITEM item;
+  PIDA_SEARCH    *search = worker->search;
+  SOLVER_CONTEXT *ctx = search->ctx;
+
+  /* Stop once another worker has found the goal (or had to stop) */
+  if (searchGoalConfirmed(&search->goal)) {
+    return IDA_INFINITY;
+  }
+  if (__atomic_load_n(&search->too_deep, __ATOMIC_RELAXED)) {
+    return IDA_TOO_DEEP;
+  }
+
+  /* Check if goal state is reached (by the move that led here) */
+  if ((g == 0) ? checkGameComplete(ctx, &worker->board) :
+                 checkMoveCompletesGame(ctx, &worker->board, worker->path[g - 1])) {
+    if (g <= threshold) {
+      if (offerSearchGoal(&search->goal, g, worker->id)) {
+        worker->path_cost = g;
+      }
+      confirmSearchGoal(&search->goal);
+      return IDA_FOUND;
+    }
+    return g;
+  }
+
+  /* Get h(n), or the better lower bound learned by an earlier search below
+     this state */
+  in_table = ttSharedLoad(&search->table, hashkey, &entry);
+
+  if (search->use_heuristic) {
+    h = get_heuristic(ctx, &worker->board);
+  }
+  if (in_table && entry.h > h) {
+    h = entry.h;
+  }
+
+  /* Cut off paths above the threshold */
+  f = (h >= TT_MAX_VALUE) ? IDA_INFINITY : g + h;
+  if (f > threshold) {
+    return f;
+  }
+
+  /* Cut off states already searched in this iteration with a lower g(n) (by
+     any worker) */
+  if (in_table && entry.iteration == search->iteration && entry.g <= g) {
+    return f;
+  }
+
+  /* No room in the path for another move */
+  if (g >= IDA_MAX_DEPTH) {
+    __atomic_store_n(&search->too_deep, true, __ATOMIC_RELAXED);
+    return IDA_TOO_DEEP;
+  }
+
+  if (!in_table) {
+    entry.key = hashkey;
+    entry.h   = 0;
+  }
+  entry.g = g;
+  entry.iteration = search->iteration;
+  ttSharedSave(&search->table, &entry);
+
+  num_moves = getAllAvailableMoves(ctx, &worker->board, available_moves);
+  countExpandedNode(&worker->stats, num_moves);
+
+  /* Near the start state, hand out each subtree as a Work Item (the last one
+     first, so that this worker takes the first one next).  The Work Items do
+     not report back to this state, so its lower bound is learned from the
+     bounds its children learned instead (i.e. one iteration later) */
+  if (g < PIDA_SPLIT_DEPTH) {
+
+    for (i = 0; i < num_moves; i++) {
+      child_hashkey = makeMove(ctx, &worker->board, available_moves[i], hashkey, &worker->key);
+      child_result = 1;
+      if (ttSharedLoad(&search->table, child_hashkey, &entry)) {
+        child_result = (entry.h >= TT_MAX_VALUE) ? IDA_INFINITY : 1 + entry.h;
+      }
+      unmakeMove(ctx, &worker->board, available_moves[i], child_hashkey, &worker->key);
+      if (child_result < result) {
+        result = child_result;
+      }
+    }
+
+    if (result > h && ttSharedLoad(&search->table, hashkey, &entry)) {
+      entry.h = (result >= TT_MAX_VALUE) ? TT_MAX_VALUE : result;
+      ttSharedSave(&search->table, &entry);
+    }
+    if (result == IDA_INFINITY || g + result > threshold) {
+      return (result == IDA_INFINITY) ? IDA_INFINITY : g + result;
+    }
+
+    item.g = g + 1;
+    memcpy(item.path, worker->path, sizeof(MOVE) * g);
+    for (i = num_moves - 1; i >= 0; i--) {
+      item.path[g] = available_moves[i];
+      pidaPushItem(worker, &item);
+    }
+    return IDA_INFINITY;
+  }
+
+  /* Make each move, search below it, and unmake it */
+  for (i = 0; i < num_moves; i++) {
+
+    child_hashkey = makeMove(ctx, &worker->board, available_moves[i], hashkey, &worker->key);
+    worker->path[g] = available_moves[i];
+    child_result = pidaSearch(worker, g + 1, threshold, child_hashkey);
+    unmakeMove(ctx, &worker->board, available_moves[i], child_hashkey, &worker->key);
+
+    if (child_result == IDA_FOUND || child_result == IDA_TOO_DEEP) {
+      return child_result;
+    }
+    if (searchGoalConfirmed(&search->goal)) {
+      return IDA_INFINITY;
+    }
+    if (child_result < result) {
+      result = child_result;
+    }
+  }
+
+  /* Remember the lower bound learned for this state (its entry may have
+     been replaced by another state in the meantime) */
+  if (!ttSharedLoad(&search->table, hashkey, &entry)) {
+    entry.key = hashkey;
+    entry.h   = 0;
+    entry.iteration = 0;
+  }
+  if (entry.iteration != search->iteration) {
+    entry.g = g;
+    entry.iteration = search->iteration;
+  }
+  if (result == IDA_INFINITY || result - g > TT_MAX_VALUE) {
+    entry.h = TT_MAX_VALUE;
+  }
+  else if (result - g > entry.h)
+  {
+    entry.h = result - g;
+  }
+  ttSharedSave(&search->table, &entry);
+
+  return result;
+
+}
+
+
+/**
+ * Function: pidaSearchItem
+ *
+ * Searches the subtree of the Work <item>: replays its moves from the start
+ * state onto the <worker>'s board, and searches below it.
+ */
+
+static void pidaSearchItem(PIDA_WORKER *worker, PIDA_ITEM *item) {
+
+  int i = 0;
+  int result = 0;
+  uint64_t hashkey = 0;
+  PIDA_SEARCH *search = worker->search;
+
+  worker->board = search->root_board;
+  worker->key   = search->root_key;
+  hashkey = search->root_hashkey;
+
+  for (i = 0; i < item->g; i++) {
+    hashkey = makeMove(search->ctx, &worker->board, item->path[i], hashkey, &worker->key);
+    worker->path[i] = item->path[i];
+  }
+
+  result = pidaSearch(worker, item->g, search->threshold, hashkey);
+  if (result != IDA_FOUND && result != IDA_TOO_DEEP && result < worker->next_threshold) {
+    worker->next_threshold = result;
+  }
+
+}
+
+
+/**
+ * Function: pidaSearchIteration
+ *
+ * Searches Work Items (its own, or stolen from the other workers) until every
+ * Work Item of the iteration has been searched, or the goal is found (or a
+ * path reached IDA_MAX_DEPTH).
+ */
+
+static void pidaSearchIteration(PIDA_WORKER *worker) {
+
+  int i = 0;
+  bool found_item = false;
+  PIDA_ITEM item;
+  PIDA_SEARCH *search = worker->search;
+
+  while (!searchGoalConfirmed(&search->goal)) {
+
+    /* Take the next Work Item (from this worker's deque, or another's) */
+    found_item = pidaTakeItem(&worker->deque, &item, false);
+    for (i = 1; i < search->num_threads && !found_item; i++) {
+      found_item = pidaTakeItem(&search->workers[(worker->id + i) % search->num_threads].deque, &item, true);
+    }
+
+    if (found_item) {
+      pidaSearchItem(worker, &item);
+      __atomic_fetch_sub(&search->pending, 1, __ATOMIC_RELEASE);
+    }
+    else if (__atomic_load_n(&search->pending, __ATOMIC_ACQUIRE) == 0)
+    {
+      return;
+    }
+    else
+    {
+      sched_yield();
+    }
+  }
+
+}
+
+
+/**
+ * Function: pidaWorkerThread
+ *
+ * Main loop of a worker thread: waits for an iteration to start, searches its
+ * share of the iteration, and waits for every other worker to finish it.
+ */
+
+static void *pidaWorkerThread(void *arg) {
+
+  PIDA_WORKER *worker = (PIDA_WORKER *) arg;
+
+  while (true) {
+
+    pthread_barrier_wait(&worker->search->start_barrier);
+    if (worker->search->done) {
+      break;
+    }
+
+    pidaSearchIteration(worker);
+    pthread_barrier_wait(&worker->search->end_barrier);
+
+  }
+
+  return NULL;
+
+}
+
+
+/**
+ * Function: parallelIterativeDeepeningAStar
+ *
+ * Performs an IDA* Search with <num_threads> worker threads on the input
+ * <board_state> of the puzzle in <ctx>.  If <use_heuristic> is false, h(n) = 0
+ * (i.e. Iterative Deepening Search).  If a solution is found, this function
+ * will return the path cost from the start state to the goal state along the
+ * solution path (the same cost as the serial IDA*).  If no solution path is
+ * found (or the search had to stop at IDA_MAX_DEPTH moves), this funcion
+ * returns -1.
+ */
+
+int parallelIterativeDeepeningAStar(SOLVER_CONTEXT *ctx, BOARD *board_state, bool use_heuristic,
+                                    int num_threads) {
+
+  int i = 0;
+  int threshold = 0;
+  int result = 0;
+  int path_cost = -1;
+  PIDA_SEARCH  search;
+  PIDA_WORKER *workers = NULL;
+  PIDA_ITEM    root_item;
+
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+  if (num_threads > PIDA_MAX_THREADS) {
+    num_threads = PIDA_MAX_THREADS;
+  }
+
+  /* The workers hold whole paths, so they are not kept on the stack */
+  workers = calloc(num_threads, sizeof(PIDA_WORKER));
+  if (workers == NULL) {
+    fprintf(stderr, "Out of memory (parallel IDA* search).\n");
+    exit(EXIT_FAILURE);
+  }
+
+  /* Initialize the Search, and the Shared Transposition Table */
+  search.ctx = ctx;
+  search.use_heuristic = use_heuristic;
+  search.root_board = *board_state;
+  getStateKey(&ctx->keys, &search.root_board, &search.root_key);
+  search.root_hashkey = getBoardHashKey(ctx, &search.root_board);
+  search.iteration = 0;
+  search.workers = workers;
+  search.num_threads = num_threads;
+  search.pending = 0;
+  search.done = false;
+  search.too_deep = false;
+  ttSharedInit(&search.table, TT_DEFAULT_SIZE_BITS);
+  initSearchGoal(&search.goal);
+
+  /* Get the Pattern Database for this puzzle (if it is used) */
+  if (use_heuristic) {
+    preparePatternDatabase(ctx, board_state);
+  }
+
+  if (use_heuristic && !checkGameComplete(ctx, board_state)) {
+    threshold = get_heuristic(ctx, board_state);
+  }
+
+  /* Start the Worker Threads */
+  pthread_barrier_init(&search.start_barrier, NULL, num_threads + 1);
+  pthread_barrier_init(&search.end_barrier, NULL, num_threads + 1);
+  for (i = 0; i < num_threads; i++) {
+    workers[i].search = &search;
+    workers[i].id = i;
+    workers[i].path_cost = -1;
+    pthread_mutex_init(&workers[i].deque.lock, NULL);
+    workers[i].deque.capacity = PIDA_DEQUE_SIZE;
+    workers[i].deque.items = malloc(sizeof(PIDA_ITEM) * PIDA_DEQUE_SIZE);
+    if (workers[i].deque.items == NULL) {
+      fprintf(stderr, "Out of memory (parallel IDA* search).\n");
+      exit(EXIT_FAILURE);
+    }
+    pthread_create(&workers[i].thread, NULL, pidaWorkerThread, &workers[i]);
+  }
+
+  /* Search with larger and larger thresholds, until a goal is reached */
+  root_item.g = 0;
+  while (threshold != IDA_INFINITY) {
+
+    /* Start the iteration with the whole tree as one Work Item */
+    search.iteration++;
+    search.threshold = threshold;
+    for (i = 0; i < num_threads; i++) {
+      workers[i].next_threshold = IDA_INFINITY;
+    }
+    pidaPushItem(&workers[0], &root_item);
+
+    pthread_barrier_wait(&search.start_barrier);
+    pthread_barrier_wait(&search.end_barrier);
+
+    if (searchGoalConfirmed(&search.goal)) {
+      break;
+    }
+    if (search.too_deep) {
+      fprintf(stderr, "Parallel IDA* search stopped: paths longer than %d moves cannot be searched.\n",
+              IDA_MAX_DEPTH);
+      break;
+    }
+
+    /* The iteration proves there is no solution within the threshold */
+    result = IDA_INFINITY;
+    for (i = 0; i < num_threads; i++) {
+      if (workers[i].next_threshold < result) {
+        result = workers[i].next_threshold;
+      }
+    }
+    threshold = (result > threshold + 1) ? result : threshold + 1;
+    if (result == IDA_INFINITY) {
+      threshold = IDA_INFINITY;
+    }
+  }
+
+  /* Stop the Worker Threads */
+  search.done = true;
+  pthread_barrier_wait(&search.start_barrier);
+  for (i = 0; i < num_threads; i++) {
+    pthread_join(workers[i].thread, NULL);
+  }
+  pthread_barrier_destroy(&search.start_barrier);
+  pthread_barrier_destroy(&search.end_barrier);
+
+  /* Print path to goal state (and print the goal state), as found by the
+     worker with the best goal state */
+  if (search.goal.worker >= 0) {
+    path_cost = workers[search.goal.worker].path_cost;
+    idaPrintSolution(ctx, &search.root_board, workers[search.goal.worker].path, path_cost);
+  }
+  freeSearchGoal(&search.goal);
+
+  /* Clean Up Memory (and report the number of states in the table) */
+  ctx->stats.closed_set_size = search.table.count;
+  for (i = 0; i < num_threads; i++) {
+    ctx->stats.nodes_expanded  += workers[i].stats.nodes_expanded;
+    ctx->stats.nodes_generated += workers[i].stats.nodes_generated;
+    pthread_mutex_destroy(&workers[i].deque.lock);
+    free(workers[i].deque.items);
+  }
+  ttSharedFree(&search.table);
+  free(workers);
+  arenaReset(&ctx->arena);
+
+  return path_cost;
+
+}
+
+
+/**
+ * Function: parallelIdaStarSearch
+ *
+ * Performs a multithreaded IDA* Search on the input <board_state>, using the
+ * same h(n) as the A* Search.  Returns the path cost of the solution, or -1.
+ */
+
+int parallelIdaStarSearch(SOLVER_CONTEXT *ctx, BOARD *board_state, int num_threads) {
+  return parallelIterativeDeepeningAStar(ctx, board_state, true, num_threads);
+}
+
+
+/**
+ * Function: parallelIterativeDeepeningSearch
+ *
+ * Performs a multithreaded Iterative Deepening Search on the input
+ * <board_state> (i.e. IDA* with h(n) = 0).  Returns the path cost of the
+ * solution, or -1.
+ */
+
+int parallelIterativeDeepeningSearch(SOLVER_CONTEXT *ctx, BOARD *board_state, int num_threads) {
+  return parallelIterativeDeepeningAStar(ctx, board_state, false, num_threads);
+}
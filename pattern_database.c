@@ -0,0 +1,627 @@
+/************************************************************************
+* FILENAME : pattern_database.c
+*
+* DESCRIPTION :
+*
+*       Implements a Pattern Database (PDB) heuristic for the A* and IDA*
+*       Searches.  The puzzle is abstracted down to the master brick plus a
+*       few of the other bricks (the ones most in the way of the master brick,
+*       i.e. covering cells it crosses on its shortest ways to the goal, as
+*       many as fit in PDB_MAX_ENTRIES), and every other brick is removed.  A
+*       backward BFS from every abstract goal state finds the exact number of
+*       moves from each abstract state to the goal, which is stored in a table
+*       of bytes.  Since removing bricks can only make the puzzle easier, the
+*       distance of a state's abstraction is an admissible (and consistent)
+*       h(n), and it counts the moves needed to get the chosen bricks out of
+*       the master brick's way, unlike the Manhattan distance.
+*
+*       Each brick of the pattern can only be at the few cells where its shape
+*       fits between the walls (its "anchors"), so an abstract state is the
+*       rank of each brick's anchor, and the table is indexed by these ranks
+*       (in mixed radix).  Looking up a board's h(n) is a single scan of its
+*       cells and one table read.
+*
+*       The table only depends on the board's size, walls, and goal cells,
+*       and the shapes of the pattern's bricks, which are kept in a header.
+*       If a directory is given, tables are saved there (named by a hash of
+*       the header), and later runs load them instead of building them again.
+*
+*       The Pattern Database is kept in the Solver Context (ctx->pdb), and is
+*       only allocated when a search first asks for it.
+*
+* PUBLIC FUNCTIONS :
+*
+*       void preparePatternDatabase(SOLVER_CONTEXT *ctx, BOARD *board_state)
+*       bool patternDatabaseReady(SOLVER_CONTEXT *ctx)
+*       int  getPatternDatabaseHeuristic(SOLVER_CONTEXT *ctx, BOARD *board_state)
+*       void freePatternDatabase(SOLVER_CONTEXT *ctx)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+/* Largest number of bricks in a pattern (the master brick included), and of
+   entries (bytes) in a table */
+#define PDB_MAX_BRICKS  8
+#define PDB_MAX_ENTRIES (1 << 22)
+
+/* Distance of abstract states that cannot reach the goal at all */
+#define PDB_UNREACHED 255
+
+/* Identifies (and versions) the Pattern Database files */
+#define PDB_MAGIC "SBPPDB01"
+
+/* Header of a Pattern Database: everything its table depends on.  Unused
+   fields are zeroed, so that two headers can be compared with memcmp */
+typedef struct PDB_HEADER {
+    char    magic[8];
+    int32_t board_width;
+    int32_t board_height;
+    int32_t num_bricks;                                  /* Master brick first   */
+    int32_t num_entries;
+    int8_t  layout[MAX_BOARD_CELLS];                     /* Walls and goal cells */
+    int8_t  shape_cells[PDB_MAX_BRICKS];
+    int8_t  shape_offsets[PDB_MAX_BRICKS][2 * MAX_BOARD_CELLS]; /* (row, col)    */
+} PDB_HEADER;
+
+/* Pattern Database: the header, how to index the table, and the table itself */
+typedef struct PATTERN_DATABASE {
+    PDB_HEADER header;
+    int8_t     brick_slot[MAX_BLOCK_NUM + 1];            /* -1 if not in pattern */
+    int        num_anchors[PDB_MAX_BRICKS];
+    int8_t     anchors[PDB_MAX_BRICKS][MAX_BOARD_CELLS];
+    int16_t    anchor_rank[PDB_MAX_BRICKS][MAX_BOARD_CELLS]; /* -1 if no fit     */
+    int32_t    strides[PDB_MAX_BRICKS];
+    uint8_t   *distances;
+    bool       ready;
+} PATTERN_DATABASE;
+
+/* Set to false to use the distance map (or Manhattan distance) alone */
+bool use_pattern_database = true;
+
+/* Directory to save and load the tables in (NULL: build every run) */
+char *pattern_database_directory = NULL;
+
+/**
+ * Function: pdbBrickShape
+ *
+ * Fills in the (row, column) offsets from the first cell of block # <block_num>
+ * on the <board_state>, and returns the block's first cell (or -1).
+ */
+
+static int pdbBrickShape(BOARD *board_state, int board_height, int board_width, int block_num,
+                         int8_t *num_cells, int8_t *offsets) {
+
+  int i = 0;
+  int first_cell = -1;
+
+  *num_cells = 0;
+  for (i = 0; i < board_height * board_width; i++) {
+    if (board_state->cells[i] == block_num) {
+      if (first_cell < 0) {
+        first_cell = i;
+      }
+      offsets[2 * *num_cells]     = i / board_width - first_cell / board_width;
+      offsets[2 * *num_cells + 1] = i % board_width - first_cell % board_width;
+      (*num_cells)++;
+    }
+  }
+
+  return first_cell;
+
+}
+
+
+/**
+ * Function: pdbFindAnchors
+ *
+ * Finds the anchors of brick # <slot> of the <pdb>'s pattern, i.e. every cell
+ * where its first cell can be without the brick leaving the board, or covering
+ * a wall (or a goal cell, unless it is the master brick).  Returns the number
+ * of anchors.
+ */
+
+static int pdbFindAnchors(PATTERN_DATABASE *pdb, int slot) {
+
+  int i,j = 0;
+  int row,col = 0;
+  bool fits = false;
+  PDB_HEADER *header = &pdb->header;
+
+  pdb->num_anchors[slot] = 0;
+  for (i = 0; i < header->board_height * header->board_width; i++) {
+
+    fits = true;
+    for (j = 0; j < header->shape_cells[slot] && fits; j++) {
+      row = i / header->board_width + header->shape_offsets[slot][2 * j];
+      col = i % header->board_width + header->shape_offsets[slot][2 * j + 1];
+      if (row < 0 || row >= header->board_height || col < 0 || col >= header->board_width ||
+          header->layout[row * header->board_width + col] == 1 ||
+          (slot > 0 && header->layout[row * header->board_width + col] == -1)) {
+        fits = false;
+      }
+    }
+
+    pdb->anchor_rank[slot][i] = fits ? pdb->num_anchors[slot] : -1;
+    if (fits) {
+      pdb->anchors[slot][pdb->num_anchors[slot]++] = i;
+    }
+  }
+
+  return pdb->num_anchors[slot];
+
+}
+
+
+/**
+ * Function: pdbChoosePattern
+ *
+ * Fills in the header of the <pdb> for the puzzle in <board_state>: the master
+ * brick, then the other bricks in order of how many of their cells are in the
+ * master brick's corridor (found with its distance <map>), and then of their
+ * distance to the goal cells, for as long as the table stays within
+ * PDB_MAX_ENTRIES.  Also lays out the table's index for these bricks.
+ */
+
+static void pdbChoosePattern(PATTERN_DATABASE *pdb, MASTER_DISTANCE_MAP *map, int board_height, int board_width,
+                             int max_block_num, BOARD *board_state) {
+
+  int i,j,k = 0;
+  int first_cell = 0;
+  int distance = 0;
+  int best = 0;
+  int num_candidates = 0;
+  long num_entries = 0;
+  int candidates[MAX_BLOCK_NUM + 1];
+  int goal_distance[MAX_BLOCK_NUM + 1];
+  int corridor_cells[MAX_BLOCK_NUM + 1];
+  uint64_t corridor = 0;
+  uint8_t start_distance[MAX_BOARD_CELLS];
+  PDB_HEADER *header = &pdb->header;
+
+  memset(header, 0, sizeof(PDB_HEADER));
+  memcpy(header->magic, PDB_MAGIC, sizeof(header->magic));
+  header->board_width  = board_width;
+  header->board_height = board_height;
+  memset(pdb->brick_slot, -1, sizeof(pdb->brick_slot));
+
+  for (i = 0; i < board_height * board_width; i++) {
+    if (board_state->cells[i] == 1 || board_state->cells[i] == -1) {
+      header->layout[i] = board_state->cells[i];
+    }
+  }
+
+  /* Corridor: the cells the Master Brick covers on its shortest ways to the
+     goal (around the walls), i.e. at the anchors on a shortest path */
+  first_cell = 0;
+  while (first_cell < board_height * board_width && board_state->cells[first_cell] != 2) {
+    first_cell++;
+  }
+  if (first_cell < board_height * board_width && map->distance[first_cell] != MASTER_UNREACHABLE) {
+    k = map->distance[first_cell];
+    memset(start_distance, MASTER_UNREACHABLE, sizeof(start_distance));
+    masterMapBFS(map, (uint64_t) 1 << first_cell, 0, start_distance);
+    for (j = 0; j < board_height * board_width; j++) {
+      if (start_distance[j] != MASTER_UNREACHABLE && map->distance[j] != MASTER_UNREACHABLE &&
+          start_distance[j] + map->distance[j] == k) {
+        corridor |= map->footprint[j];
+      }
+    }
+  }
+
+  /* Cells of each brick in the corridor, and its distance to the nearest goal
+     cell */
+  for (i = 3; i <= max_block_num && i <= MAX_BLOCK_NUM; i++) {
+    goal_distance[i] = -1;
+    corridor_cells[i] = 0;
+    for (j = 0; j < board_height * board_width; j++) {
+      if (board_state->cells[j] != i) {
+        continue;
+      }
+      corridor_cells[i] += (corridor >> j) & 1;
+      for (k = 0; k < board_height * board_width; k++) {
+        if (header->layout[k] == -1) {
+          distance = abs(j / board_width - k / board_width) + abs(j % board_width - k % board_width);
+          if (goal_distance[i] < 0 || distance < goal_distance[i]) {
+            goal_distance[i] = distance;
+          }
+        }
+      }
+    }
+    if (goal_distance[i] >= 0) {
+      candidates[num_candidates++] = i;
+    }
+  }
+
+  /* The Master Brick always comes first */
+  first_cell = pdbBrickShape(board_state, board_height, board_width, 2,
+                             &header->shape_cells[0], header->shape_offsets[0]);
+  if (first_cell < 0) {
+    header->num_bricks = 0;
+    return;
+  }
+  header->num_bricks = 1;
+  pdb->brick_slot[2] = 0;
+  num_entries = pdbFindAnchors(pdb, 0);
+
+  /* Then the bricks most in the corridor (the closest first) that still fit */
+  while (num_candidates > 0 && header->num_bricks < PDB_MAX_BRICKS) {
+
+    best = 0;
+    for (i = 1; i < num_candidates; i++) {
+      if (corridor_cells[candidates[i]] > corridor_cells[candidates[best]] ||
+          (corridor_cells[candidates[i]] == corridor_cells[candidates[best]] &&
+           goal_distance[candidates[i]] < goal_distance[candidates[best]])) {
+        best = i;
+      }
+    }
+    k = candidates[best];
+    candidates[best] = candidates[--num_candidates];
+
+    j = header->num_bricks;
+    pdbBrickShape(board_state, board_height, board_width, k, &header->shape_cells[j], header->shape_offsets[j]);
+    if (num_entries * pdbFindAnchors(pdb, j) > PDB_MAX_ENTRIES) {
+      header->shape_cells[j] = 0;
+      memset(header->shape_offsets[j], 0, sizeof(header->shape_offsets[j]));
+      continue;
+    }
+
+    num_entries *= pdb->num_anchors[j];
+    pdb->brick_slot[k] = j;
+    header->num_bricks++;
+  }
+
+  header->num_entries = (int32_t) num_entries;
+  pdb->strides[0] = 1;
+  for (i = 1; i < header->num_bricks; i++) {
+    pdb->strides[i] = pdb->strides[i - 1] * pdb->num_anchors[i - 1];
+  }
+
+}
+
+
+/**
+ * Function: pdbPlaceBricks
+ *
+ * Decodes the <pdb>'s abstract state <index> into the anchor of each brick,
+ * and marks the cells covered by each brick (slot + 1) in <occupied>.  Returns
+ * false if two bricks overlap.
+ */
+
+static bool pdbPlaceBricks(PATTERN_DATABASE *pdb, int32_t index, int *anchors, int8_t *occupied) {
+
+  int i,j = 0;
+  int cell = 0;
+  PDB_HEADER *header = &pdb->header;
+
+  memset(occupied, 0, MAX_BOARD_CELLS);
+  for (i = 0; i < header->num_bricks; i++) {
+    anchors[i] = pdb->anchors[i][(index / pdb->strides[i]) % pdb->num_anchors[i]];
+    for (j = 0; j < header->shape_cells[i]; j++) {
+      cell = anchors[i] + header->shape_offsets[i][2 * j] * header->board_width +
+             header->shape_offsets[i][2 * j + 1];
+      if (occupied[cell] != 0) {
+        return false;
+      }
+      occupied[cell] = i + 1;
+    }
+  }
+
+  return true;
+
+}
+
+
+/**
+ * Function: pdbBuild
+ *
+ * Fills in the <pdb>'s table with a BFS backward from every abstract goal state
+ * (a move and its reverse are both legal, so the BFS just makes moves).
+ */
+
+static void pdbBuild(PATTERN_DATABASE *pdb) {
+
+  int i,j,k = 0;
+  int row,col = 0;
+  int cell = 0;
+  int new_anchor = 0;
+  int32_t index = 0;
+  int32_t new_index = 0;
+  int32_t head = 0;
+  int32_t tail = 0;
+  int32_t *queue = NULL;
+  bool is_goal = false;
+  bool fits = false;
+  int anchors[PDB_MAX_BRICKS];
+  int8_t occupied[MAX_BOARD_CELLS];
+  PDB_HEADER *header = &pdb->header;
+
+  queue = malloc(sizeof(int32_t) * header->num_entries);
+  if (queue == NULL) {
+    fprintf(stderr, "Out of memory (pattern database).\n");
+    exit(EXIT_FAILURE);
+  }
+  memset(pdb->distances, PDB_UNREACHED, header->num_entries);
+
+  /* Abstract goal states: the master brick covers every goal cell */
+  for (index = 0; index < header->num_entries; index++) {
+    if (!pdbPlaceBricks(pdb, index, anchors, occupied)) {
+      continue;
+    }
+    is_goal = true;
+    for (i = 0; i < header->board_height * header->board_width; i++) {
+      if (header->layout[i] == -1 && occupied[i] != 1) {
+        is_goal = false;
+      }
+    }
+    if (is_goal) {
+      pdb->distances[index] = 0;
+      queue[tail++] = index;
+    }
+  }
+
+  /* Breadth First Search over the abstract states */
+  while (head < tail) {
+
+    index = queue[head++];
+    pdbPlaceBricks(pdb, index, anchors, occupied);
+
+    for (i = 0; i < header->num_bricks; i++) {
+      for (k = UP; k <= RIGHT; k++) {
+
+        /* Brick has to fit between the walls at its new anchor... */
+        row = anchors[i] / header->board_width + Move_Row_Deltas[k];
+        col = anchors[i] % header->board_width + Move_Col_Deltas[k];
+        if (row < 0 || row >= header->board_height || col < 0 || col >= header->board_width) {
+          continue;
+        }
+        new_anchor = row * header->board_width + col;
+        if (pdb->anchor_rank[i][new_anchor] < 0) {
+          continue;
+        }
+
+        /* ...and not run into another brick of the pattern */
+        fits = true;
+        for (j = 0; j < header->shape_cells[i] && fits; j++) {
+          cell = new_anchor + header->shape_offsets[i][2 * j] * header->board_width +
+                 header->shape_offsets[i][2 * j + 1];
+          if (occupied[cell] != 0 && occupied[cell] != i + 1) {
+            fits = false;
+          }
+        }
+        if (!fits) {
+          continue;
+        }
+
+        new_index = index + (pdb->anchor_rank[i][new_anchor] - pdb->anchor_rank[i][anchors[i]]) * pdb->strides[i];
+        if (pdb->distances[new_index] == PDB_UNREACHED && pdb->distances[index] + 1 < PDB_UNREACHED) {
+          pdb->distances[new_index] = pdb->distances[index] + 1;
+          queue[tail++] = new_index;
+        }
+      }
+    }
+  }
+
+  free(queue);
+
+}
+
+
+/**
+ * Function: pdbFileName
+ *
+ * Writes the name of the file for the <pdb>'s table (in the Pattern Database
+ * directory) into <file_name>.  The name is an FNV-1a hash of the header.
+ */
+
+static void pdbFileName(PATTERN_DATABASE *pdb, char *file_name, size_t size) {
+
+  size_t i = 0;
+  uint64_t hash = 14695981039346656037ULL;
+  uint8_t *bytes = (uint8_t *) &pdb->header;
+
+  for (i = 0; i < sizeof(PDB_HEADER); i++) {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+
+  snprintf(file_name, size, "%s/sbp-%016llx.pdb", pattern_database_directory, (unsigned long long) hash);
+
+}
+
+
+/**
+ * Function: pdbLoad
+ *
+ * Loads the <pdb>'s table from its file.  Returns false if there is no such
+ * file, or it is not for the same header.
+ */
+
+static bool pdbLoad(PATTERN_DATABASE *pdb) {
+
+  char file_name[FILENAME_MAX];
+  bool loaded = false;
+  PDB_HEADER file_header;
+  FILE *file = NULL;
+
+  pdbFileName(pdb, file_name, sizeof(file_name));
+  file = fopen(file_name, "rb");
+  if (file == NULL) {
+    return false;
+  }
+
+  if (fread(&file_header, sizeof(PDB_HEADER), 1, file) == 1 &&
+      memcmp(&file_header, &pdb->header, sizeof(PDB_HEADER)) == 0 &&
+      fread(pdb->distances, 1, pdb->header.num_entries, file) == (size_t) pdb->header.num_entries) {
+    loaded = true;
+  }
+
+  fclose(file);
+  return loaded;
+
+}
+
+
+/**
+ * Function: pdbSave
+ *
+ * Saves the <pdb>'s table to its file (written under a temporary name, then
+ * renamed, so that a run never loads a partly written file).
+ */
+
+static void pdbSave(PATTERN_DATABASE *pdb) {
+
+  char file_name[FILENAME_MAX];
+  char temp_name[FILENAME_MAX + 8];
+  bool saved = false;
+  int  fd = -1;
+  FILE *file = NULL;
+
+  /* The temporary name is unique, even between the threads of a batch */
+  pdbFileName(pdb, file_name, sizeof(file_name));
+  snprintf(temp_name, sizeof(temp_name), "%s.XXXXXX", file_name);
+
+  fd = mkstemp(temp_name);
+  if (fd >= 0) {
+    file = fdopen(fd, "wb");
+    if (file == NULL) {
+      close(fd);
+    }
+  }
+  if (file != NULL) {
+    saved = fwrite(&pdb->header, sizeof(PDB_HEADER), 1, file) == 1 &&
+            fwrite(pdb->distances, 1, pdb->header.num_entries, file) == (size_t) pdb->header.num_entries;
+    saved = (fclose(file) == 0) && saved;
+  }
+
+  if (!saved || rename(temp_name, file_name) != 0) {
+    fprintf(stderr, "Could not save pattern database: %s\n", file_name);
+    remove(temp_name);
+  }
+
+}
+
+
+/**
+ * Function: preparePatternDatabase
+ *
+ * Gets the Pattern Database of the <ctx> ready for the puzzle in <board_state>
+ * (with the board size and highest block of the <ctx>): the table in memory
+ * is kept if it is for the same header, and otherwise it is loaded from the
+ * Pattern Database directory, or built (and saved there).
+ */
+
+void preparePatternDatabase(SOLVER_CONTEXT *ctx, BOARD *board_state) {
+
+  PDB_HEADER old_header;
+  bool had_table = false;
+  PATTERN_DATABASE *pdb = ctx->pdb;
+
+  if (!use_pattern_database) {
+    if (pdb != NULL) {
+      pdb->ready = false;
+    }
+    return;
+  }
+
+  if (pdb == NULL) {
+    pdb = ctx->pdb = calloc(1, sizeof(PATTERN_DATABASE));
+    if (pdb == NULL) {
+      fprintf(stderr, "Out of memory (pattern database).\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  old_header = pdb->header;
+  had_table = pdb->ready;
+  pdb->ready = false;
+
+  pdbChoosePattern(pdb, &ctx->distance_map, ctx->board_height, ctx->board_width, ctx->max_block_num, board_state);
+  if (pdb->header.num_bricks == 0) {
+    return;
+  }
+
+  if (had_table && memcmp(&old_header, &pdb->header, sizeof(PDB_HEADER)) == 0) {
+    pdb->ready = true;
+    return;
+  }
+
+  free(pdb->distances);
+  pdb->distances = malloc(pdb->header.num_entries);
+  if (pdb->distances == NULL) {
+    fprintf(stderr, "Out of memory (pattern database).\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if (pattern_database_directory == NULL || !pdbLoad(pdb)) {
+    pdbBuild(pdb);
+    if (pattern_database_directory != NULL) {
+      pdbSave(pdb);
+    }
+  }
+
+  pdb->ready = true;
+
+}
+
+
+/**
+ * Function: patternDatabaseReady
+ *
+ * Returns true if the <ctx> has a Pattern Database for its current puzzle.
+ */
+
+bool patternDatabaseReady(SOLVER_CONTEXT *ctx) {
+  return ctx->pdb != NULL && ctx->pdb->ready;
+}
+
+
+/**
+ * Function: getPatternDatabaseHeuristic
+ *
+ * Returns the Pattern Database's h(n) of the <board_state>, i.e. the distance
+ * to the goal of its abstract state (the <ctx>'s Pattern Database must be
+ * ready).
+ */
+
+int getPatternDatabaseHeuristic(SOLVER_CONTEXT *ctx, BOARD *board_state) {
+
+  int i = 0;
+  int slot = 0;
+  int found = 0;
+  int32_t index = 0;
+  bool seen[PDB_MAX_BRICKS] = {false};
+  PATTERN_DATABASE *pdb = ctx->pdb;
+
+  for (i = 0; i < pdb->header.board_height * pdb->header.board_width && found < pdb->header.num_bricks; i++) {
+    if (board_state->cells[i] < 2) {
+      continue;
+    }
+    slot = pdb->brick_slot[board_state->cells[i]];
+    if (slot >= 0 && !seen[slot]) {
+      seen[slot] = true;
+      index += pdb->anchor_rank[slot][i] * pdb->strides[slot];
+      found++;
+    }
+  }
+
+  return pdb->distances[index];
+
+}
+
+
+/**
+ * Function: freePatternDatabase
+ *
+ * Cleans up the memory used by the Pattern Database of the <ctx>.
+ */
+
+void freePatternDatabase(SOLVER_CONTEXT *ctx) {
+
+  if (ctx->pdb != NULL) {
+    free(ctx->pdb->distances);
+    free(ctx->pdb);
+    ctx->pdb = NULL;
+  }
+
+}
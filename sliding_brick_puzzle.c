@@ -11,20 +11,33 @@
  *       getting a list of available moves, applying those moves, checking if two states
  *       are equivalent, normalizing a state, and performing a random walk.
  *
+ *       Most of them work on a puzzle loaded into a Solver Context (see
+ *       utilities/solver_context.c), which they take as their first argument.
+ *       The inner loops of the busiest ones are Board Kernels, specialized for
+ *       the common board sizes (see utilities/board_kernels.c), which are
+ *       selected for the puzzle's size when it is loaded.
+ *
  * PUBLIC FUNCTIONS :
  *
- *       void  loadGameState(char *filename)
- *       void  printState(int **board_state)
- *       void  printGameState()
- *       int **cloneGameState(int ** orig_state)
- *       bool  checkGameComplete(int ** game_state)
- *       int   getAvailableMoves(int **input_state, int piece_num, MOVE **available_moves)
- *       int   getAllAvailableMoves(int **input_state, MOVE **available_moves)
- *       void  applyMove(int **input_state, MOVE move)
- *       int **applyMoveCloning(int **input_state, MOVE move)
- *       bool  compareStates(int **state_a, int **state_b)
- *       void  normalizeState(int **input_state)
- *       void  randomWalk(int **board_state, int N)
+ *       void   loadGameState(SOLVER_CONTEXT *ctx, char *filename)
+ *       void   clearGameState(SOLVER_CONTEXT *ctx)
+ *       void   printState(SOLVER_CONTEXT *ctx, BOARD *board_state)
+ *       void   printGameState(SOLVER_CONTEXT *ctx)
+ *       BOARD *cloneGameState(BOARD *orig_state)
+ *       bool   checkGameComplete(SOLVER_CONTEXT *ctx, BOARD *game_state)
+ *       bool   checkMoveCompletesGame(SOLVER_CONTEXT *ctx, BOARD *game_state, MOVE move)
+ *       uint64_t getBoardHashKey(SOLVER_CONTEXT *ctx, BOARD *input_state)
+ *       int    getAvailableMoves(SOLVER_CONTEXT *ctx, BOARD *input_state, int piece_num, MOVE *available_moves)
+ *       int    getAllAvailableMoves(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE *available_moves)
+ *       void   applyMove(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move)
+ *       void   undoMove(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move)
+ *       uint64_t makeMove(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move, uint64_t hashkey, STATE_KEY *key)
+ *       uint64_t unmakeMove(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move, uint64_t hashkey, STATE_KEY *key)
+ *       BOARD *applyMoveCloning(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move)
+ *       bool   compareStates(BOARD *state_a, BOARD *state_b)
+ *       void   normalizeState(SOLVER_CONTEXT *ctx, BOARD *input_state)
+ *       int    randomWalk(SOLVER_CONTEXT *ctx, BOARD *board_state, int N)
+ *       void   scrambleGameState(SOLVER_CONTEXT *ctx, BOARD *board_state, int N, unsigned int seed)
  *
  * AUTHOR : Philip Cheng
  * DATE   : 18 October 2017
@@ -35,56 +48,97 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/wait.h>
 
 /* Includes Move and Graph definitions */
 #include "definitions.h"
 
+/* Function Declarations */
+void   loadGameState(SOLVER_CONTEXT *ctx, char *filename);
+void   clearGameState(SOLVER_CONTEXT *ctx);
+void   printState(SOLVER_CONTEXT *ctx, BOARD *board_state);
+void   printGameState(SOLVER_CONTEXT *ctx);
+BOARD *cloneGameState(BOARD *orig_state);
+bool   checkGameComplete(SOLVER_CONTEXT *ctx, BOARD *game_state);
+bool   checkMoveCompletesGame(SOLVER_CONTEXT *ctx, BOARD *game_state, MOVE move);
+uint64_t getBoardHashKey(SOLVER_CONTEXT *ctx, BOARD *input_state);
+int    getAvailableMoves(SOLVER_CONTEXT *ctx, BOARD *input_state, int piece_num, MOVE *available_moves);
+int    getAllAvailableMoves(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE *available_moves);
+void   applyMove(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move);
+void   undoMove(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move);
+uint64_t makeMove(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move, uint64_t hashkey, STATE_KEY *key);
+uint64_t unmakeMove(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move, uint64_t hashkey, STATE_KEY *key);
+BOARD *applyMoveCloning(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move);
+bool   compareStates(BOARD *state_a, BOARD *state_b);
+void   normalizeState(SOLVER_CONTEXT *ctx, BOARD *input_state);
+int    randomWalk(SOLVER_CONTEXT *ctx, BOARD *board_state, int N);
+void   scrambleGameState(SOLVER_CONTEXT *ctx, BOARD *board_state, int N, unsigned int seed);
+
 /* Include Utilities Functions */
-#include "utilities/printer.c"
+#include "utilities/board_simd.c"
+#include "utilities/canonical_key.c"
 #include "utilities/run_timer.c"
+#include "utilities/search_stats.c"
+#include "utilities/search_goal.c"
+#include "utilities/search_arena.c"
 #include "utilities/bfs_fifo_queue.c"
 #include "utilities/dfs_filo_stack.c"
+#include "utilities/astar_open_list.c"
+#include "utilities/path_store.c"
+#include "utilities/master_distance_map.c"
 #include "utilities/state_hash_table.c"
+#include "utilities/transposition_table.c"
 
-/* Function Declarations */
-void  loadGameState(char *filename);
-void  printState(int **board_state);
-void  printGameState();
-int **cloneGameState(int ** orig_state);
-bool  checkGameComplete(int ** game_state);
-int   getAvailableMoves(int **input_state, int piece_num, MOVE **available_moves);
-int   getAllAvailableMoves(int **input_state, MOVE **available_moves);
-void  applyMove(int **input_state, MOVE move);
-int **applyMoveCloning(int **input_state, MOVE move);
-bool  compareStates(int **state_a, int **state_b);
-void  normalizeState(int **input_state);
-void  randomWalk(int **board_state, int N);
-
-/* Includes A-Star, BFS, and DFS Search Implementations */
+/* Frees the Pattern Database of a Solver Context (see the Pattern Database) */
+void   freePatternDatabase(SOLVER_CONTEXT *ctx);
+
+/* Includes the Solver Context (made of the utilities above), the Board Kernels
+   that run on it, and the printing of the solutions that the searches find */
+#include "utilities/solver_context.c"
+#include "utilities/board_kernels.c"
+#include "utilities/printer.c"
+
+/* Includes A-Star, BFS, and DFS Search Implementations (and their variants) */
+#include "pattern_database.c"
 #include "a_star_search.c"
+#include "ida_star_search.c"
 #include "breadth_first_search.c"
 #include "depth_first_search.c"
+#include "parallel_breadth_first_search.c"
+#include "parallel_ida_star_search.c"
+#include "hash_distributed_a_star_search.c"
+#include "external_memory_bfs.c"
+
+/* Includes the Command Line Interface */
+#include "utilities/command_line.c"
+
+/* Solves one puzzle file with every selected search (see the Batch Solver) */
+void   solvePuzzle(SBP_OPTIONS *options, char *file_name, FILE *output, int *num_results_printed);
+
+/* Includes the Batch Solver */
+#include "utilities/batch_solver.c"
 
 /*******************/
 /* Game State Info */
 /*******************/
 
-int   board_width   = 0;     /* Number of columns on the board           */
-int   board_height  = 0;     /* Number of rows on the board              */
-int   max_block_num = 0;     /* Number of the highest block on the board */
-int **board_state   = NULL;  /* 2-D Array of board's contents            */
-
-
 /**
  * Function: loadGameState
  *
- * Loads a game state from disk given an ASCII text file: <filename>. If file is
- * not found, this function simply returns, without any additional error message.
+ * Loads a game state from disk given an ASCII text file: <filename>, into the
+ * Solver Context <ctx>. If file is not found, this function simply returns,
+ * without any additional error message (and ctx->board_state stays NULL).
+ * If the file is truncated, or holds a bad board size or block number, an
+ * error message is printed, and ctx->board_state is also left NULL, so the
+ * puzzle is rejected.
  * It is assumed that the user provides a valid file name, to enable loading of
  * a sliding brick puzzle map.
  */
 
-void loadGameState(char *filename) {
+void loadGameState(SOLVER_CONTEXT *ctx, char *filename) {
 
   char input_buffer[MAX_BLOCK_NUM_CHARS] = {0};
   char input_char = 0;
@@ -101,9 +155,15 @@ void loadGameState(char *filename) {
   do {
     input_char = getc(file);
     input_buffer[i++] = input_char;
-  } while (input_char != ',');
+  } while (input_char != ',' && input_char != EOF && i < MAX_BLOCK_NUM_CHARS - 1);
 
-  board_width = (int) strtol(input_buffer, &dummy_ptr, 10);
+  if (input_char != ',') {
+    fprintf(stderr, "Bad or missing board size.\n");
+    fclose(file);
+    return;
+  }
+
+  ctx->board_width = (int) strtol(input_buffer, &dummy_ptr, 10);
   memset(&input_buffer[0], 0, sizeof(input_buffer));
 
   /* Get Board Height */
@@ -111,20 +171,47 @@ void loadGameState(char *filename) {
   do {
     input_char = getc(file);
     input_buffer[i++] = input_char;
-  } while (input_char != ',');
+  } while (input_char != ',' && input_char != EOF && i < MAX_BLOCK_NUM_CHARS - 1);
+
+  if (input_char != ',') {
+    fprintf(stderr, "Bad or missing board size.\n");
+    fclose(file);
+    return;
+  }
 
-  board_height = (int) strtol(input_buffer, &dummy_ptr, 10);
+  ctx->board_height = (int) strtol(input_buffer, &dummy_ptr, 10);
   memset(&input_buffer[0], 0, sizeof(input_buffer));
 
-  /* Create Board */
-  board_state  = malloc(sizeof(int *) * board_height);
-  for (i = 0; i < board_height; i++) {
-    board_state[i] = malloc(sizeof(int) * board_width);
+  /* Make sure the Board has cells at all */
+  if (ctx->board_width <= 0 || ctx->board_height <= 0) {
+    fprintf(stderr, "Bad board size (%d x %d).\n", ctx->board_width, ctx->board_height);
+    ctx->board_width  = 0;
+    ctx->board_height = 0;
+    fclose(file);
+    return;
+  }
+
+  /* Make sure the Board fits into a packed BOARD (checking each side first,
+     so the product cannot overflow) */
+  if (ctx->board_width > MAX_BOARD_CELLS || ctx->board_height > MAX_BOARD_CELLS ||
+      ctx->board_width * ctx->board_height > MAX_BOARD_CELLS) {
+    fprintf(stderr, "Board is too large (more than %d cells).\n", MAX_BOARD_CELLS);
+    ctx->board_width  = 0;
+    ctx->board_height = 0;
+    fclose(file);
+    return;
   }
 
+  /* Select the Board Kernels for this board size */
+  selectBoardKernels(ctx);
+
+  /* Create Board */
+  ctx->board_state = calloc(1, sizeof(BOARD));
+  memset(&ctx->board_layout, 0, sizeof(BOARD));
+
   /* Fill in Board */
-  for (j = 0; j < board_height; j++) {
-    for (k = 0; k < board_width; k++) {
+  for (j = 0; j < ctx->board_height; j++) {
+    for (k = 0; k < ctx->board_width; k++) {
 
       i = 0;
       do {
@@ -133,12 +220,15 @@ void loadGameState(char *filename) {
 
         /* Check for early EOF */
         if (input_char == EOF) {
-          printf("EOF happened prematurely.\n");
+          fprintf(stderr, "EOF happened prematurely.\n");
+          fclose(file);
+          free(ctx->board_state);
+          ctx->board_state = NULL;
           return;
         }
 
         /* Get next Input Char */
-        if (input_char != '\n') {
+        if (input_char != '\n' && i < MAX_BLOCK_NUM_CHARS - 1) {
           input_buffer[i++] = input_char;
         }
 
@@ -147,40 +237,63 @@ void loadGameState(char *filename) {
       /* Update square on Board (and zero out the input_buffer) */
       block_num = (int) strtol(input_buffer, &dummy_ptr, 10);
       memset(&input_buffer[0], 0, sizeof(input_buffer));
-      board_state[j][k] = block_num;
+      if (block_num > MAX_BLOCK_NUM) {
+        fprintf(stderr, "Block number %d is too large.\n", block_num);
+        fclose(file);
+        free(ctx->board_state);
+        ctx->board_state = NULL;
+        return;
+      }
+      ctx->board_state->cells[j * ctx->board_width + k] = (int8_t) block_num;
+
+      /* Walls and Goal cells never move, so keep them in the Board Layout */
+      if (block_num == 1 || block_num == -1) {
+        ctx->board_layout.cells[j * ctx->board_width + k] = (int8_t) block_num;
+      }
+
+      /* Record the Goal cells, for the goal test */
+      if (block_num == -1) {
+        ctx->goal_cells[ctx->num_goal_cells++] = j * ctx->board_width + k;
+      }
 
       /* Update Max Block Num */
-      if (block_num > max_block_num) {
-        max_block_num = block_num;
+      if (block_num > ctx->max_block_num) {
+        ctx->max_block_num = block_num;
       }
 
     }
   }
+
+  fclose(file);
+
+  /* Sort the bricks into shape classes, for the canonical keys */
+  initShapeClasses(&ctx->keys, ctx->board_state, ctx->board_height, ctx->board_width, ctx->max_block_num);
+
+  /* Compute the Master Brick's distances to the goal, for the heuristic */
+  initMasterDistanceMap(&ctx->distance_map, ctx->board_state, ctx->board_height, ctx->board_width);
+
 }
 
 
 /**
  * Function: clearGameState
  *
- * Cleans up memory allocated by the game <board_state> and resets board values
- * to their default values, so that the game state is ready to start a new game.
+ * Cleans up memory allocated by the game board_state of the <ctx> and resets
+ * board values to their default values, so that the game state is ready to
+ * start a new game.
  */
 
-void clearGameState() {
-
-  int i = 0;
+void clearGameState(SOLVER_CONTEXT *ctx) {
 
   /* Perform Garbage Collection */
-  for (i = 0; i < board_height; i++) {
-    free(board_state[i]);
-  }
-  free(board_state);
+  free(ctx->board_state);
 
   /* Reset Game Paramenters */
-  board_height  = 0;
-  board_width   = 0;
-  max_block_num = 0;
-  board_state   = NULL;
+  ctx->board_height  = 0;
+  ctx->board_width   = 0;
+  ctx->max_block_num = 0;
+  ctx->num_goal_cells = 0;
+  ctx->board_state   = NULL;
 
 }
 
@@ -188,22 +301,23 @@ void clearGameState() {
 /**
  * Function: printState
  *
- * Prints an input game state <board_state> to the screen.
+ * Prints an input game state <board_state> (of the puzzle in <ctx>) to the
+ * output of the <ctx>.
  */
 
-void printState(int **board_state) {
+void printState(SOLVER_CONTEXT *ctx, BOARD *board_state) {
 
   int  i,j = 0;
 
-  printf("%d,%d,\n", board_width, board_height);
+  fprintf(ctx->output, "%d,%d,\n", ctx->board_width, ctx->board_height);
 
-  for (i = 0; i < board_height; i++) {
-    for (j = 0; j < board_width; j++) {
-      printf("%d,", board_state[i][j]);
+  for (i = 0; i < ctx->board_height; i++) {
+    for (j = 0; j < ctx->board_width; j++) {
+      fprintf(ctx->output, "%d,", board_state->cells[i * ctx->board_width + j]);
     }
-    printf("\n");
+    fprintf(ctx->output, "\n");
   }
-  printf("\n");
+  fprintf(ctx->output, "\n");
 
 }
 
@@ -211,11 +325,11 @@ void printState(int **board_state) {
 /**
  * Function: printGameState
  *
- * Prints an the current game state to the screen.
+ * Prints an the current game state of the <ctx> to its output.
  */
 
-void printGameState() {
-  printState(board_state);
+void printGameState(SOLVER_CONTEXT *ctx) {
+  printState(ctx, ctx->board_state);
 }
 
 
@@ -225,23 +339,11 @@ void printGameState() {
  * Creates and returns a copy of an input game state <orig_state>.
  */
 
-int **cloneGameState(int ** orig_state) {
-
-  int i,j = 0;
-  int **new_board = 0;
-
-  /* Create a New Board */
-  new_board  = malloc(sizeof(int *) * board_height);
-  for (i = 0; i < board_height; i++) {
-    new_board[i] = malloc(sizeof(int) * board_width);
-  }
+BOARD *cloneGameState(BOARD *orig_state) {
 
-  /* Copy Board Contents */
-  for (i = 0; i < board_height; i++) {
-    for (j = 0; j < board_width; j++) {
-      new_board[i][j] = orig_state[i][j];
-    }
-  }
+  /* Create a New Board, and Copy Board Contents */
+  BOARD *new_board = malloc(sizeof(BOARD));
+  *new_board = *orig_state;
 
   return new_board;
 
@@ -253,17 +355,17 @@ int **cloneGameState(int ** orig_state) {
  *
  * Returns true if the game state is a SOLVED state, i.e. no -1 blocks are
  * included in the game's state because they are presumably covered by a 2-block.
+ * Only the goal cells (recorded when the puzzle was loaded) are checked, as no
+ * other cell can hold a -1.
  */
 
-bool checkGameComplete(int ** game_state) {
+bool checkGameComplete(SOLVER_CONTEXT *ctx, BOARD *game_state) {
 
-  int i,j = 0;
+  int i = 0;
 
-  for (i = 0; i < board_height; i++) {
-    for (j = 0; j < board_width; j++) {
-      if (game_state[i][j] == -1) {
-        return false;
-      }
+  for (i = 0; i < ctx->num_goal_cells; i++) {
+    if (game_state->cells[ctx->goal_cells[i]] == -1) {
+      return false;
     }
   }
   return true;
@@ -272,142 +374,65 @@ bool checkGameComplete(int ** game_state) {
 
 
 /**
- * Function: getAvailableMoves
+ * Function: checkMoveCompletesGame
  *
- * Searches the <input_state> for all possible legal moves generated by moving
- * block # <piece_num>.  Returns a pointer to an array of moves.
+ * Returns true if the <move>, which led to the <game_state>, solved the game.
+ * Only the master brick can move onto a goal cell, so no other brick's move
+ * can solve the game, and those moves are ruled out without looking at the
+ * board at all.
  */
 
-int getAvailableMoves(int **input_state, int piece_num, MOVE **available_moves) {
-
-  /* Temporary Variables */
-  int   i,j = 0;
-  MOVE* local_available_moves = NULL;
-  int   num_available_moves   = 4;
+bool checkMoveCompletesGame(SOLVER_CONTEXT *ctx, BOARD *game_state, MOVE move) {
+  return move.block_num == 2 && checkGameComplete(ctx, game_state);
+}
 
-  /* Move Checkers */
-  bool piece_found = false;
-  bool up_legal    = true;
-  bool down_legal  = true;
-  bool left_legal  = true;
-  bool right_legal = true;
 
-  /* Scan board looking for piece matching <piece_num> */
-  for (i = 0; i < board_height; i++) {
-    for (j = 0; j < board_width; j++) {
-      if (input_state[i][j] == piece_num) {
-
-        piece_found = true;
-
-        /* Check if Up Direction is a Legal Move */
-        if (up_legal == true) {
-          if (i == 0 ||
-             (piece_num == 2 &&
-               input_state[i - 1][j] != 0  &&
-               input_state[i - 1][j] != -1 &&
-               input_state[i - 1][j] != piece_num) ||
-             (piece_num != 2 &&
-               input_state[i - 1][j] != 0  &&
-               input_state[i - 1][j] != piece_num)) {
-
-            up_legal = false;
-            num_available_moves--;
-
-          }
-        }
+/**
+ * Function: getBoardHashKey
+ *
+ * Calculates the 64-bit Zobrist Hash Key of an <input_state> of the puzzle in
+ * the <ctx> (the same hash as getStateHashKey, with the ctx's key layout).
+ */
 
-        /* Check Down Direction */
-        if (down_legal == true) {
-          if (i == (board_height - 1) ||
-             (piece_num == 2 &&
-               input_state[i + 1][j] != 0  &&
-               input_state[i + 1][j] != -1 &&
-               input_state[i + 1][j] != piece_num) ||
-             (piece_num != 2 &&
-               input_state[i + 1][j] != 0  &&
-               input_state[i + 1][j] != piece_num)) {
-
-            down_legal = false;
-            num_available_moves--;
-
-          }
-        }
+uint64_t getBoardHashKey(SOLVER_CONTEXT *ctx, BOARD *input_state) {
+  return ctx->kernels->getBoardHashKey(ctx, input_state);
+}
 
-        /* Check Left Direction */
-        if (left_legal == true) {
-          if (j == 0 ||
-             (piece_num == 2 &&
-               input_state[i][j - 1] != 0  &&
-               input_state[i][j - 1] != -1 &&
-               input_state[i][j - 1] != piece_num) ||
-             (piece_num != 2 &&
-               input_state[i][j - 1] != 0  &&
-               input_state[i][j - 1] != piece_num)) {
-
-            left_legal = false;
-            num_available_moves--;
-
-          }
-        }
 
-        /* Check Right Direction */
-        if (right_legal == true) {
+/**
+ * Function: getAvailableMoves
+ *
+ * Searches the <input_state> for all possible legal moves generated by moving
+ * block # <piece_num>.  Writes the moves into the caller-provided array
+ * <available_moves> (room for 4 moves), and returns the number of moves.
+ */
 
-          if (j == (board_width - 1) ||
-             (piece_num == 2 &&
-               input_state[i][j + 1] != 0  &&
-               input_state[i][j + 1] != -1 &&
-               input_state[i][j + 1] != piece_num) ||
-             (piece_num != 2 &&
-               input_state[i][j + 1] != 0  &&
-               input_state[i][j + 1] != piece_num)) {
+int getAvailableMoves(SOLVER_CONTEXT *ctx, BOARD *input_state, int piece_num, MOVE *available_moves) {
 
-            right_legal = false;
-            num_available_moves--;
+  int  i = 0;
+  int  num_cells = ctx->board_height * ctx->board_width;
+  int  num_available_moves = 0;
+  int  blocked = 0;
+  bool piece_found = false;
+  Move_Direction direction = UP;
 
-          }
-        }
-      }
+  /* Scan board looking for piece matching <piece_num> */
+  for (i = 0; i < num_cells; i++) {
+    if (input_state->cells[i] == piece_num) {
+      piece_found = true;
+      blocked |= getBlockedDirections_generic_scalar(ctx, input_state, i, piece_num);
     }
   }
 
-  if (piece_found) {
-
-    if (num_available_moves > 0) {
-
-      i = 0;
-      local_available_moves = malloc(sizeof(MOVE) * num_available_moves);
-
-      if (up_legal) {
-        local_available_moves[i].block_num = piece_num;
-        local_available_moves[i].direction = UP;
-        i++;
-      }
-
-      if (down_legal) {
-        local_available_moves[i].block_num = piece_num;
-        local_available_moves[i].direction = DOWN;
-        i++;
-      }
-
-      if (left_legal) {
-        local_available_moves[i].block_num = piece_num;
-        local_available_moves[i].direction = LEFT;
-        i++;
-      }
-
-      if (right_legal) {
-        local_available_moves[i].block_num = piece_num;
-        local_available_moves[i].direction = RIGHT;
-        i++;
-      }
-
-      *available_moves = local_available_moves;
+  if (!piece_found) {
+    return 0;
+  }
 
-    }
-    else
-    {
-      available_moves = NULL;
+  for (direction = UP; direction <= RIGHT; direction++) {
+    if (!(blocked & (1 << direction))) {
+      available_moves[num_available_moves].block_num = piece_num;
+      available_moves[num_available_moves].direction = direction;
+      num_available_moves++;
     }
   }
 
@@ -420,105 +445,81 @@ int getAvailableMoves(int **input_state, int piece_num, MOVE **available_moves)
  * Function: getAllAvailableMoves
  *
  * Searches the <input_state> for all possible legal moves generated by moving
- * any moveable block in the game state.  Returns a pointer to an array of moves.
+ * any moveable block in the game state.  This takes a single pass over the
+ * board, checking only the cells adjacent to each block.  Writes the moves into
+ * the caller-provided array <available_moves> (room for MAX_AVAILABLE_MOVES),
+ * ordered by block number, and returns the number of moves.
  */
 
-/* Gets the list of ALL available moves for the board state */
-int getAllAvailableMoves(int **input_state, MOVE **available_moves) {
-
-  int    i,j,k = 0;
-  int    num_total_available_moves = 0;
-  MOVE  *local_available_moves     = 0;
-  MOVE **available_moves_per_block = malloc(sizeof(MOVE*));
-  int    num_moves = 0;
+int getAllAvailableMoves(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE *available_moves) {
+  return ctx->kernels->getAllAvailableMoves(ctx, input_state, available_moves);
+}
 
-  /* Count Number of Total Available Moves */
-  for (i = 2; i <= max_block_num; i++) {
-    num_moves = getAvailableMoves(input_state, i, available_moves_per_block);
-    num_total_available_moves += num_moves;
-  }
 
-  /* Allocate memory for New Array (containing all moves for all blocks) */
-  local_available_moves = malloc(sizeof(MOVE) * num_total_available_moves);
+/**
+ * Function: applyMove
+ *
+ * Applies the <move> to the game defined by <input_state>, and updates the
+ * original <input state> contents with the game's next state.  Only the cells
+ * that the moving block leaves or enters are written.
+ */
 
-  /* Copy moves to New Array */
-  i = 0;
-  for (j = 2; j <= max_block_num; j++) {
-    num_moves = getAvailableMoves(input_state, j, available_moves_per_block);
-    for (k = 0; k < num_moves; k++){
-      local_available_moves[i++] = (*available_moves_per_block)[k];
-    }
-  }
+void applyMove(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move) {
 
-  /* Update Output */
-  *available_moves = local_available_moves;
-  return num_total_available_moves;
+  ctx->kernels->moveBlockCells(ctx, input_state, move, NULL);
 
 }
 
 
 /**
- * Function: applyMove
+ * Function: undoMove
  *
- * Applies the <move> to the game defined by <input_state>, and updates the
- * original <input state> contents with the game's next state.
+ * Undoes a <move> that was applied to the <input_state> (with applyMove), by
+ * moving the same block back in the opposite direction.
  */
 
-void applyMove(int **input_state, MOVE move) {
+void undoMove(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move) {
 
-  int i,j = 0;
-  int temp_board[board_height][board_width];
+  move.direction = Opposite_Directions[move.direction];
+  ctx->kernels->moveBlockCells(ctx, input_state, move, NULL);
 
-  /* Copy state to the temp_board (minus the block that will move) */
-  for (i = 0; i < board_height; i++) {
-    for (j = 0; j < board_width; j++) {
-      if (input_state[i][j] == move.block_num) {
-        temp_board[i][j] = 0;
-      }
-      else
-      {
-        temp_board[i][j] = input_state[i][j];
-      }
-    }
-  }
+}
 
-  /* Copy a moved version of the moving block to the temp_board */
-  for (i = 0; i < board_height; i++) {
-    for (j = 0; j < board_width; j++) {
-      if (input_state[i][j] == move.block_num) {
 
-        switch (move.direction) {
+/**
+ * Function: makeMove
+ *
+ * Applies the <move> to the <input_state> in place, and updates the state's
+ * canonical <key> for it.  Returns the Zobrist hash of the new state, updated
+ * from the old state's <hashkey> for only the cells that changed.  No block is
+ * ever renumbered, since neither the key nor the hash depends on block numbers.
+ */
 
-          case UP:
-            temp_board[i-1][j] = move.block_num;
-            break;
+uint64_t makeMove(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move, uint64_t hashkey, STATE_KEY *key) {
 
-          case DOWN:
-            temp_board[i+1][j] = move.block_num;
-            break;
+  int old_first_cell = ctx->kernels->moveBlockCells(ctx, input_state, move, &hashkey);
+  int new_first_cell = old_first_cell + Move_Row_Deltas[move.direction] * ctx->board_width
+                                      + Move_Col_Deltas[move.direction];
 
-          case LEFT:
-            temp_board[i][j-1] = move.block_num;
-            break;
+  updateStateKey(&ctx->keys, key, move.block_num, old_first_cell, new_first_cell);
 
-          case RIGHT:
-            temp_board[i][j+1] = move.block_num;
-            break;
+  return hashkey;
 
-          default:
-            break;
+}
 
-        }
-      }
-    }
-  }
 
-  /* Overwrite the original state */
-  for (i = 0; i < board_height; i++) {
-    for (j = 0; j < board_width; j++) {
-      input_state[i][j] = temp_board[i][j];
-    }
-  }
+/**
+ * Function: unmakeMove
+ *
+ * Takes back a <move> made with makeMove, given the <hashkey> of the
+ * <input_state> after the move, by moving the same block back.  Restores the
+ * state and its canonical <key> exactly, and returns the restored state's hash.
+ */
+
+uint64_t unmakeMove(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move, uint64_t hashkey, STATE_KEY *key) {
+
+  move.direction = Opposite_Directions[move.direction];
+  return makeMove(ctx, input_state, move, hashkey, key);
 
 }
 
@@ -530,10 +531,10 @@ void applyMove(int **input_state, MOVE move) {
  * the cloned version of the next game state (with the move applied).
  */
 
-int **applyMoveCloning(int **input_state, MOVE move) {
+BOARD *applyMoveCloning(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move) {
 
-  int** board_clone = cloneGameState(input_state);
-  applyMove(board_clone, move);
+  BOARD *board_clone = cloneGameState(input_state);
+  applyMove(ctx, board_clone, move);
   return board_clone;
 
 }
@@ -546,17 +547,8 @@ int **applyMoveCloning(int **input_state, MOVE move) {
  * if the two states are equal, and false if they are not.
  */
 
-bool compareStates(int **state_a, int **state_b) {
-
-  int i,j = 0;
-  for (i = 0; i < board_height; i++) {
-    for (j = 0; j < board_width; j++) {
-      if (state_a[i][j] != state_b[i][j]) {
-        return false;
-      }
-    }
-  }
-  return true;
+bool compareStates(BOARD *state_a, BOARD *state_b) {
+  return boardsEqual(state_a, state_b);
 }
 
 
@@ -567,42 +559,8 @@ bool compareStates(int **state_a, int **state_b) {
  * numbers arranged in incrementing numbers from the top-left to the bottom-right.
  */
 
-void normalizeState(int **input_state) {
-
-  int i,j = 0;
-
-  int  block_num = 0;
-  bool *block_seen = malloc(sizeof(bool) * max_block_num);
-
-  int *remap = malloc(sizeof(int) * max_block_num);
-  int remap_counter = 3;
-
-  /* Initialize block_seen */
-  for (i = 0; i <= max_block_num; i++) {
-    block_seen[i] = false;
-    remap[i] = 0;
-  }
-
-  /* Create Re-map Plan */
-  for (i = 0; i < board_height; i++) {
-    for (j = 0; j < board_width; j++) {
-      block_num = input_state[i][j];
-      if (block_num > 2 && !block_seen[block_num]) {
-        block_seen[block_num] = true;
-        remap[block_num] = remap_counter++;
-      }
-    }
-  }
-
-  /* Re-map, to create Normalized State */
-  for (i = 0; i < board_height; i++) {
-    for (j = 0; j < board_width; j++) {
-      if (input_state[i][j] > 2) {
-        input_state[i][j] = remap[input_state[i][j]];
-      }
-    }
-  }
-
+void normalizeState(SOLVER_CONTEXT *ctx, BOARD *input_state) {
+  ctx->kernels->normalizeState(ctx, input_state);
 }
 
 
@@ -611,131 +569,461 @@ void normalizeState(int **input_state) {
  *
  * Performs a Random Walk with N steps in the game, given an input <board_state>
  * as a starting point.  The Random Walk ends when either the game is solved, or
- * the number of steps taken by the Random Walk reaches N.
+ * the number of steps taken by the Random Walk reaches N.  Returns the number
+ * of steps taken if the game was solved, and -1 otherwise.
  */
 
-void randomWalk(int **board_state, int N) {
+int randomWalk(SOLVER_CONTEXT *ctx, BOARD *board_state, int N) {
 
   int num_steps = 0;
   int num_moves = 0;
   int rand_num  = 0;
 
-  MOVE **available_moves = malloc(sizeof(MOVE*));
+  MOVE available_moves[MAX_AVAILABLE_MOVES];
 
-  bool goal_reached = checkGameComplete(board_state);
+  bool goal_reached = checkGameComplete(ctx, board_state);
 
   /* Set Random Seed */
   srand(time(NULL));
 
   /* Normalize and print the initial state */
-  normalizeState(board_state);
-  printState(board_state);
+  normalizeState(ctx, board_state);
+  if (print_solution) {
+    printState(ctx, board_state);
+  }
 
   while (num_steps < N && !goal_reached) {
 
     /* Generate all moves from initial_state */
-    num_moves = getAllAvailableMoves(board_state, available_moves);
+    num_moves = getAllAvailableMoves(ctx, board_state, available_moves);
+    countExpandedNode(&ctx->stats, num_moves);
 
     /* Select and Execute one move randomly */
     rand_num = rand() % num_moves;
-    applyMove(board_state, (*available_moves)[rand_num]);
-    printMove(&((*available_moves)[rand_num]));
-    printf("\n");
+    applyMove(ctx, board_state, available_moves[rand_num]);
 
     /* Normalize and print the new state */
-    normalizeState(board_state);
-    printState(board_state);
+    normalizeState(ctx, board_state);
+    if (print_solution) {
+      printMove(ctx, &available_moves[rand_num]);
+      fprintf(ctx->output, "\n");
+      printState(ctx, board_state);
+    }
 
     /* Check if Goal is reached */
-    goal_reached = checkGameComplete(board_state);
+    goal_reached = checkGameComplete(ctx, board_state);
 
     num_steps++;
 
   }
 
-  return;
+  return goal_reached ? num_steps : -1;
 
 }
 
 
-/***************************************************************************
- * MAIN FUNCTION
- ***************************************************************************/
+/**
+ * Function: scrambleGameState
+ *
+ * Scrambles the <board_state> with N random moves (never stepping onto a goal
+ * state), using a random number generator seeded with <seed>, so that the same
+ * seed always produces the same scrambled puzzle.  Used to generate variants
+ * of the puzzles for benchmarking.
+ */
 
-int main() {
+void scrambleGameState(SOLVER_CONTEXT *ctx, BOARD *board_state, int N, unsigned int seed) {
 
-  int  path_cost = 0;
-  char file_name[] = "text_files/SBP-level3.txt";
+  int   num_steps = 0;
+  int   num_moves = 0;
+  int   num_tries = 0;
+  BOARD next_board_state;
+  MOVE  move;
+  MOVE  available_moves[MAX_AVAILABLE_MOVES];
 
-  /* Select which Search Algorithms to Run: */
-  bool test_random = true;
-  bool test_bfs    = true;
-  bool test_dfs    = true;
-  bool test_ids    = true;
-  bool test_ass    = false;
+  while (num_steps < N) {
+
+    /* Select one move randomly (retrying if it would solve the puzzle) */
+    num_moves = getAllAvailableMoves(ctx, board_state, available_moves);
+    if (num_moves == 0) {
+      break;
+    }
+
+    next_board_state = *board_state;
+    move = available_moves[rand_r(&seed) % num_moves];
+    applyMove(ctx, &next_board_state, move);
+
+    if (!checkMoveCompletesGame(ctx, &next_board_state, move)) {
+      *board_state = next_board_state;
+      num_steps++;
+      num_tries = 0;
+    }
+    else if (++num_tries > MAX_AVAILABLE_MOVES)
+    {
+      break;
+    }
 
-  /* Random Walk Example */
-  if (test_random) {
-    loadGameState(file_name);
-    randomWalk(board_state, 3);
-    clearGameState();
   }
 
-  /* Breadth First Search */
-  if (test_bfs) {
-    loadGameState(file_name);
-    initStateHashTable(board_height, board_width, max_block_num);
-    startRunTimer();
-    path_cost = breadthFirstSearch(board_height, board_width, max_block_num, board_state);
-    endRunTimer();
-    printf("%d ", hash_table_node_count);
-    printElapsedRunTime();
-    printf(" %d\n\n", path_cost);
-    resetHashTable();
-    clearGameState();
+}
+
+
+/**
+ * Function: executeSearch
+ *
+ * Solves the puzzle in the <ctx> with the search <algorithm>.  Returns the
+ * path cost found by the search, or -1.
+ */
+
+static int executeSearch(SOLVER_CONTEXT *ctx, SBP_OPTIONS *options, Search_Algorithm algorithm) {
+
+  int path_cost = -1;
+
+  switch (algorithm) {
+
+    case RANDOM_WALK:
+      path_cost = randomWalk(ctx, ctx->board_state, RANDOM_WALK_STEPS);
+      break;
+
+    case BFS:
+      path_cost = breadthFirstSearch(ctx, ctx->board_state);
+      break;
+
+    case DFS:
+      path_cost = depthFirstSearch(ctx, ctx->board_state);
+      break;
+
+    case IDS:
+      path_cost = interativeDeepeningSearch(ctx, ctx->board_state);
+      break;
+
+    case ASTAR:
+      path_cost = aStarSearch(ctx, ctx->board_state);
+      break;
+
+    case IDA_STAR:
+      path_cost = idaStarSearch(ctx, ctx->board_state);
+      break;
+
+    case PARALLEL_BFS:
+      path_cost = parallelBreadthFirstSearch(ctx, ctx->board_state, options->num_threads);
+      break;
+
+    case EXTERNAL_BFS:
+      path_cost = externalBreadthFirstSearch(ctx, ctx->board_state, options->ebfs_memory_mb,
+                                                    options->ebfs_directory);
+      break;
+
+    case PARALLEL_IDS:
+      path_cost = parallelIterativeDeepeningSearch(ctx, ctx->board_state, options->num_threads);
+      break;
+
+    case PARALLEL_IDA_STAR:
+      path_cost = parallelIdaStarSearch(ctx, ctx->board_state, options->num_threads);
+      break;
+
+    case HDA_STAR:
+      path_cost = hashDistributedAStarSearch(ctx, ctx->board_state, options->num_threads);
+      break;
+
+    default:
+      break;
+
   }
 
-  /* Depth First Search */
-  if (test_dfs) {
-    loadGameState(file_name);
-    initStateHashTable(board_height, board_width, max_block_num);
-    startRunTimer();
-    path_cost = depthFirstSearch(board_height, board_width, max_block_num, board_state);
-    endRunTimer();
-    printf ("%d ", hash_table_node_count);
-    printElapsedRunTime();
-    printf(" %d\n\n", path_cost);
-    resetHashTable();
-    clearGameState();
+  return path_cost;
+
+}
+
+
+/**
+ * Function: timeSearch
+ *
+ * Solves the puzzle in the <ctx> with the search <algorithm>, and fills in the
+ * path cost, counters and times of the <result> (but not its peak memory).
+ */
+
+static void timeSearch(SOLVER_CONTEXT *ctx, SBP_OPTIONS *options, Search_Algorithm algorithm,
+                       SEARCH_RESULT *result) {
+
+  RUN_TIMER timer;
+
+  resetSearchStats(&ctx->stats);
+  startRunTimer(&timer);
+  result->path_cost = executeSearch(ctx, options, algorithm);
+  endRunTimer(&timer);
+
+  result->closed_set_size = ctx->stats.closed_set_size;
+  result->nodes_expanded  = ctx->stats.nodes_expanded;
+  result->nodes_generated = ctx->stats.nodes_generated;
+  result->wall_seconds    = getElapsedWallTime(&timer);
+  result->cpu_seconds     = getElapsedRunTime(&timer);
+
+}
+
+
+/**
+ * Function: runMeasuredSearch
+ *
+ * Solves the puzzle in the <ctx> with the search <algorithm> in a child
+ * process forked for it, and fills in the <result>, including the peak memory
+ * of the search alone (see search_stats.c).  The CPU time is the child's, so
+ * it does not include the other puzzles of a batch either.  The child's
+ * output (its solution path) goes through a pipe to the output of the <ctx>,
+ * and its result through a second pipe.  If no process can be forked, the
+ * search runs in this one, and its peak memory is reported as unknown (-1).
+ * Returns false if the child did not finish (e.g. it ran out of memory).
+ * Only used for the output formats that report the peak memory.
+ */
+
+static bool runMeasuredSearch(SOLVER_CONTEXT *ctx, SBP_OPTIONS *options, Search_Algorithm algorithm,
+                              SEARCH_RESULT *result) {
+
+  static pthread_mutex_t fork_lock = PTHREAD_MUTEX_INITIALIZER;
+
+  int     status = 0;
+  int     output_fds[2];
+  int     result_fds[2];
+  int     null_fd = -1;
+  long    start_peak_kb = 0;
+  char    buffer[4096];
+  ssize_t bytes_read = 0;
+  pid_t   pid = -1;
+  SEARCH_RESULT child_result;
+
+  /* Fork (one thread at a time, so that no other child inherits the write
+     ends of these pipes, and keeps them open) */
+  fflush(ctx->output);
+  pthread_mutex_lock(&fork_lock);
+  if (pipe(output_fds) == 0) {
+    if (pipe(result_fds) == 0) {
+      pid = fork();
+      if (pid < 0) {
+        close(result_fds[0]);
+        close(result_fds[1]);
+      }
+    }
+    if (pid < 0) {
+      close(output_fds[0]);
+      close(output_fds[1]);
+    }
+  }
+  if (pid > 0) {
+    close(output_fds[1]);
+    close(result_fds[1]);
   }
+  pthread_mutex_unlock(&fork_lock);
 
-  /* Iterative Deepening Depth First Search */
-  if (test_ids) {
-    loadGameState(file_name);
-    initStateHashTable(board_height, board_width, max_block_num);
-    startRunTimer();
-    path_cost = interativeDeepeningSearch(board_height, board_width, max_block_num, board_state);
-    endRunTimer();
-    printf ("%d ", hash_table_node_count);
-    printElapsedRunTime();
-    printf(" %d\n\n", path_cost);
-    resetHashTable();
-    clearGameState();
+  /* No Child: run the search here */
+  if (pid < 0) {
+    timeSearch(ctx, options, algorithm, result);
+    result->peak_memory_kb = -1;
+    return true;
   }
 
-  /* A-Star Search */
-  if (test_ass) {
-    loadGameState(file_name);
-    initStateHashTable(board_height, board_width, max_block_num);
-    startRunTimer();
-    path_cost = aStarSearch(board_height, board_width, max_block_num, board_state);
-    endRunTimer();
-    printf ("%d ", hash_table_node_count);
-    printElapsedRunTime();
-    printf(" %d\n\n", path_cost);
-    resetHashTable();
-    clearGameState();
+  /* Child: run the search, with its output going into the pipe (and anything
+     left in the buffer of stdout, when it was forked, going nowhere) */
+  if (pid == 0) {
+    close(output_fds[0]);
+    close(result_fds[0]);
+    null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+      dup2(null_fd, STDOUT_FILENO);
+      close(null_fd);
+    }
+    ctx->output = fdopen(output_fds[1], "w");
+    if (ctx->output == NULL) {
+      _exit(EXIT_FAILURE);
+    }
+
+    start_peak_kb = getPeakMemoryKB();
+    timeSearch(ctx, options, algorithm, result);
+    result->peak_memory_kb = (start_peak_kb < 0) ? -1 : getPeakMemoryKB() - start_peak_kb;
+
+    fflush(ctx->output);
+    if (write(result_fds[1], result, sizeof(SEARCH_RESULT)) != (ssize_t) sizeof(SEARCH_RESULT)) {
+      _exit(EXIT_FAILURE);
+    }
+    _exit(0);
+  }
+
+  /* Parent: pass the child's output on, then read its result */
+  while ((bytes_read = read(output_fds[0], buffer, sizeof(buffer))) != 0) {
+    if (bytes_read > 0) {
+      fwrite(buffer, 1, bytes_read, ctx->output);
+    }
+    else if (errno != EINTR)
+    {
+      break;
+    }
+  }
+  bytes_read = read(result_fds[0], &child_result, sizeof(SEARCH_RESULT));
+  close(output_fds[0]);
+  close(result_fds[0]);
+  waitpid(pid, &status, 0);
+
+  if (bytes_read != (ssize_t) sizeof(SEARCH_RESULT) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return false;
+  }
+
+  result->path_cost       = child_result.path_cost;
+  result->closed_set_size = child_result.closed_set_size;
+  result->nodes_expanded  = child_result.nodes_expanded;
+  result->nodes_generated = child_result.nodes_generated;
+  result->wall_seconds    = child_result.wall_seconds;
+  result->cpu_seconds     = child_result.cpu_seconds;
+  result->peak_memory_kb  = child_result.peak_memory_kb;
+  return true;
+
+}
+
+
+/**
+ * Function: runSearch
+ *
+ * Loads the puzzle in <file_name> into the <ctx> (scrambled by <scramble_steps>
+ * random moves, if that is not zero), solves it with the search <algorithm>,
+ * and prints the result of this <run> in the output format selected in
+ * <options>.  Returns the path cost found by the search, or -1.
+ */
+
+int runSearch(SOLVER_CONTEXT *ctx, SBP_OPTIONS *options, char *file_name, int scramble_steps,
+              Search_Algorithm algorithm, int run) {
+
+  int  i = 0;
+  char puzzle_name[FILENAME_MAX + 32];
+  unsigned int scramble_seed = 0;
+  SEARCH_RESULT result;
+
+  /* Load the Puzzle */
+  loadGameState(ctx, file_name);
+  if (ctx->board_state == NULL) {
+    fprintf(stderr, "Could not load puzzle file: %s\n", file_name);
+    clearGameState(ctx);
+    return -1;
+  }
+
+  /* Scramble the Puzzle (seeded by its file name, for repeatable runs) */
+  if (scramble_steps > 0) {
+    for (i = 0; file_name[i] != '\0'; i++) {
+      scramble_seed = scramble_seed * 31 + (unsigned char) file_name[i];
+    }
+    scrambleGameState(ctx, ctx->board_state, scramble_steps, scramble_seed);
+    snprintf(puzzle_name, sizeof(puzzle_name), "%s+scramble%d", file_name, scramble_steps);
+  }
+  else
+  {
+    snprintf(puzzle_name, sizeof(puzzle_name), "%s", file_name);
+  }
+
+  result.puzzle      = puzzle_name;
+  result.algorithm   = algorithm;
+  result.num_threads = (algorithm == PARALLEL_BFS || algorithm == PARALLEL_IDS ||
+                        algorithm == PARALLEL_IDA_STAR || algorithm == HDA_STAR) ? options->num_threads : 1;
+  result.run         = run;
+  result.path_cost   = -1;
+
+  /* Build (or load) the Pattern Database of the Puzzle before the timer starts,
+     so that the search time of the heuristic searches is measured on its own */
+  if (algorithm == ASTAR || algorithm == IDA_STAR || algorithm == PARALLEL_IDA_STAR ||
+      algorithm == HDA_STAR) {
+    preparePatternDatabase(ctx, ctx->board_state);
+  }
+
+  /* Run the Search, and Report the Results.  Only the CSV and JSON formats
+     report the peak memory, so only they run the search in a process of its
+     own (to measure it); the text format runs it in this process */
+  if (options->output_format == TEXT_OUTPUT) {
+    timeSearch(ctx, options, algorithm, &result);
+    result.peak_memory_kb = -1;
+  }
+  else if (!runMeasuredSearch(ctx, options, algorithm, &result)) {
+    fprintf(stderr, "Search did not finish: %s (%s)\n", puzzle_name, Algorithm_Strings[algorithm]);
+    releaseSearchMemory(ctx);
+    clearGameState(ctx);
+    return -1;
+  }
+  printSearchResult(ctx, options, &result);
+
+  /* Give the memory used by the search back to the system (if it ran in this
+     process) */
+  releaseSearchMemory(ctx);
+  clearGameState(ctx);
+
+  return result.path_cost;
+
+}
+
+
+/**
+ * Function: solvePuzzle
+ *
+ * Solves the puzzle in <file_name> (and its scrambled variant, if requested)
+ * with each selected search algorithm, as many times as requested in <options>.
+ * The runs share one Solver Context (so a Pattern Database is only made once).
+ * The solutions and results are printed to the <output>, which already holds
+ * <num_results_printed> results (updated as more are printed).
+ */
+
+void solvePuzzle(SBP_OPTIONS *options, char *file_name, FILE *output, int *num_results_printed) {
+
+  int j,k,run = 0;
+  int scramble_steps = 0;
+  SOLVER_CONTEXT ctx;
+
+  initSolverContext(&ctx);
+  ctx.output = output;
+  ctx.num_results_printed = *num_results_printed;
+
+  for (k = 0; k < ((options->scramble_steps > 0) ? 2 : 1); k++) {
+    scramble_steps = (k == 0) ? 0 : options->scramble_steps;
+    for (j = 0; j < NUM_ALGORITHMS; j++) {
+      if (options->algorithms[j]) {
+        for (run = 1; run <= options->num_repeats; run++) {
+          runSearch(&ctx, options, file_name, scramble_steps, (Search_Algorithm) j, run);
+        }
+      }
+    }
+  }
+
+  *num_results_printed = ctx.num_results_printed;
+  freeSolverContext(&ctx);
+
+}
+
+
+/***************************************************************************
+ * MAIN FUNCTION
+ ***************************************************************************/
+
+int main(int argc, char **argv) {
+
+  int i = 0;
+  SBP_OPTIONS options;
+
+  /* Read the Command Line Options (and the Puzzle List) */
+  if (!parseCommandLine(argc, argv, &options) || !applyMemoryLimit(&options)) {
+    return 1;
+  }
+  if (options.puzzle_list != NULL && !loadPuzzleList(&options)) {
+    return 1;
+  }
+  print_solution = !options.quiet;
+  use_distance_map = (options.heuristic != MANHATTAN_HEURISTIC);
+  use_pattern_database = (options.heuristic == PDB_HEURISTIC);
+  pattern_database_directory = options.pdb_directory;
+
+  /* Solve each Puzzle, one at a time, or in a Batch of worker threads */
+  printResultsHeader(&options);
+  if (options.num_jobs > 1) {
+    runBatch(&options);
+  }
+  else
+  {
+    for (i = 0; i < options.num_files; i++) {
+      solvePuzzle(&options, options.file_names[i], stdout, &num_results_printed);
+    }
   }
+  printResultsFooter(&options);
 
   return 0;
 
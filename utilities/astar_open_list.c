@@ -0,0 +1,167 @@
+/************************************************************************
+* FILENAME : astar_open_list.c
+*
+* DESCRIPTION :
+*
+*       Implements a bucketed priority queue (the "Open Set") for use in the
+*       A* Search algorithm.  Since every move costs exactly 1, the values of
+*       f(n) = g(n) + h(n) are small non-negative integers, so each f(n) value
+*       gets its own bucket (a linked list of State Nodes).  Pushing a node is
+*       O(1), and popping the best node is amortized O(1), since the lowest
+*       non-empty bucket only moves forward (for a consistent heuristic).
+*       The nodes are allocated from the search's arena (and the A* Search gives
+*       each one back to the arena once it is expanded), or are made by the
+*       caller and pushed as they are (see astarPushOpenListNode).
+*
+* PUBLIC FUNCTIONS :
+*
+*       void astarPushOpenList(ASTAR_OPEN_LIST *open_list, ARENA *arena, BOARD *board_state, int path_cost,
+*                              int path_index, int heuristic)
+*       void astarPushOpenListNode(ASTAR_OPEN_LIST *open_list, STATE_NODE *node)
+*       STATE_NODE* astarPopOpenList(ASTAR_OPEN_LIST *open_list)
+*       bool astarOpenListIsEmpty(ASTAR_OPEN_LIST *open_list)
+*       void astarClearOpenList(ASTAR_OPEN_LIST *open_list)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+/* Initial number of f(n) buckets (the bucket array grows as needed) */
+#define ASTAR_INITIAL_BUCKETS 256
+
+/* A* Open List: its buckets, indexed by f(n), the lowest (possibly) non-empty
+   bucket, and the number of Nodes in it */
+typedef struct ASTAR_OPEN_LIST {
+    STATE_NODE **buckets;
+    int          num_buckets;
+    int          min_f;
+    int          size;
+} ASTAR_OPEN_LIST;
+
+
+/**
+ * Function: astarPushOpenListNode
+ *
+ * Pushes an existing State <node> (with its path cost and cached heuristic
+ * filled in) into the bucket of the <open_list> for its f(n).  The node is
+ * linked into the bucket through its next pointer.
+ */
+
+void astarPushOpenListNode(ASTAR_OPEN_LIST *open_list, STATE_NODE *node) {
+
+  int i = 0;
+  int f_of_n = 0;
+  int new_num_buckets = 0;
+
+  /* Grow the Bucket Array (if f(n) does not fit yet) */
+  f_of_n = node->path_cost + node->heuristic;
+  if (f_of_n >= open_list->num_buckets) {
+
+    new_num_buckets = (open_list->num_buckets > 0) ? open_list->num_buckets : ASTAR_INITIAL_BUCKETS;
+    while (f_of_n >= new_num_buckets) {
+      new_num_buckets *= 2;
+    }
+
+    open_list->buckets = realloc(open_list->buckets, sizeof(STATE_NODE *) * new_num_buckets);
+    for (i = open_list->num_buckets; i < new_num_buckets; i++) {
+      open_list->buckets[i] = NULL;
+    }
+    open_list->num_buckets = new_num_buckets;
+  }
+
+  /* Push onto the front of the bucket (deeper Nodes get expanded first) */
+  node->next = open_list->buckets[f_of_n];
+  open_list->buckets[f_of_n] = node;
+
+  /* Update the lowest bucket (only happens for an inconsistent heuristic) */
+  if (open_list->size == 0 || f_of_n < open_list->min_f) {
+    open_list->min_f = f_of_n;
+  }
+  open_list->size++;
+
+}
+
+
+/**
+ * Function: astarPushOpenList
+ *
+ * Creates a State Node (in the <arena>) with a copy of the given information
+ * (board_state, path cost, Path Store index, and cached heuristic) and pushes
+ * the Node into the bucket of the <open_list> for its f(n).
+ */
+
+void astarPushOpenList(ASTAR_OPEN_LIST *open_list, ARENA *arena, BOARD *board_state, int path_cost,
+                       int path_index, int heuristic) {
+
+  /* Create the new State Node */
+  STATE_NODE *new_node = arenaAllocNode(arena);
+  new_node->board_state = *board_state;
+  new_node->move_from_parent = 0;
+  new_node->parent = NULL;
+  new_node->path_index = path_index;
+  new_node->path_cost = path_cost;
+  new_node->heuristic = heuristic;
+
+  astarPushOpenListNode(open_list, new_node);
+
+}
+
+
+/**
+ * Function: astarPopOpenList
+ *
+ * Pops and returns a pointer to a State Node with the lowest f(n) in the
+ * <open_list>.  Returns NULL if the Open List is empty.
+ */
+
+STATE_NODE* astarPopOpenList(ASTAR_OPEN_LIST *open_list) {
+
+  STATE_NODE *return_node = NULL;
+
+  if (open_list->size == 0) {
+    return NULL;
+  }
+
+  /* Skip forward over empty buckets */
+  while (open_list->buckets[open_list->min_f] == NULL) {
+    open_list->min_f++;
+  }
+
+  return_node = open_list->buckets[open_list->min_f];
+  open_list->buckets[open_list->min_f] = return_node->next;
+  open_list->size--;
+
+  return return_node;
+
+}
+
+
+/**
+ * Function: astarOpenListIsEmpty
+ *
+ * Returns true is the A* <open_list> is empty
+ */
+
+bool astarOpenListIsEmpty(ASTAR_OPEN_LIST *open_list) {
+  return (open_list->size == 0);
+}
+
+
+/**
+ * Function: astarClearOpenList
+ *
+ * Empties out the A* <open_list> and releases its bucket array, so that the
+ * Open List is ready for a brand new search.
+ */
+
+void astarClearOpenList(ASTAR_OPEN_LIST *open_list) {
+
+  free(open_list->buckets);
+
+  open_list->buckets     = NULL;
+  open_list->num_buckets = 0;
+  open_list->min_f       = 0;
+  open_list->size        = 0;
+
+}
@@ -0,0 +1,464 @@
+/************************************************************************
+* FILENAME : batch_solver.c
+*
+* DESCRIPTION :
+*
+*       Implements the batch mode of the sliding brick puzzle solver, which
+*       solves many puzzle files in one run: the puzzle list can be read from
+*       a manifest (one file name per line) or a directory, and up to N
+*       puzzles are solved at the same time.
+*
+*       The puzzles are solved by a pool of N worker threads, which take the
+*       next puzzle off the list as soon as they are done with the last one.
+*       Each puzzle gets a Solver Context of its own, and its output is
+*       collected in a memory buffer, which is printed as a whole as soon as
+*       the puzzle is solved, so results stream out in the order they finish,
+*       and the output of different puzzles is never mixed up.
+*
+*       In isolation mode, each puzzle is instead solved in a worker process
+*       of its own, forked from this one, whose output goes through a pipe.
+*       This fully isolates the puzzles from each other: a puzzle that runs
+*       out of memory, or crashes, does not take the others with it.
+*
+* PUBLIC FUNCTIONS :
+*
+*       bool loadPuzzleList(SBP_OPTIONS *options)
+*       void runBatch(SBP_OPTIONS *options)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+#include <dirent.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+/* Size of each read from a worker's pipe */
+#define BATCH_READ_SIZE 4096
+
+/* Represents the Pool of worker threads, which share the puzzle list */
+typedef struct BATCH_POOL {
+    SBP_OPTIONS    *options;
+    pthread_mutex_t lock;          /* Guards next_file, and printing */
+    int             next_file;     /* Next puzzle to be solved       */
+} BATCH_POOL;
+
+/* Represents a Worker process, solving one puzzle (in isolation mode) */
+typedef struct BATCH_WORKER {
+    pid_t  pid;             /* Worker process (0 if the slot is free) */
+    int    fd;              /* Read end of the worker's output pipe   */
+    char  *file_name;       /* Puzzle being solved                    */
+    char  *output;          /* Output so far                          */
+    size_t output_size;
+    size_t output_capacity;
+} BATCH_WORKER;
+
+
+/**
+ * Function: addPuzzleFile
+ *
+ * Appends a copy of <file_name> to the puzzle files in <options> (whose array
+ * has room for <capacity> names, and is grown as needed).
+ */
+
+static void addPuzzleFile(SBP_OPTIONS *options, int *capacity, char *file_name) {
+
+  if (options->num_files == *capacity) {
+    *capacity = (*capacity > 0) ? *capacity * 2 : 64;
+    options->file_names = realloc(options->file_names, sizeof(char *) * *capacity);
+    if (options->file_names == NULL) {
+      fprintf(stderr, "Out of memory (batch solver).\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  options->file_names[options->num_files++] = strdup(file_name);
+
+}
+
+
+/**
+ * Function: comparePuzzleNames
+ *
+ * Orders two puzzle file names alphabetically (for qsort).
+ */
+
+static int comparePuzzleNames(const void *name_a, const void *name_b) {
+  return strcmp(*(char * const *) name_a, *(char * const *) name_b);
+}
+
+
+/**
+ * Function: loadPuzzleList
+ *
+ * Adds the puzzles of the puzzle list in <options> to its puzzle files.  The
+ * list is either a directory (every ".txt" file in it, in alphabetical order)
+ * or a manifest file (one puzzle file per line; blank lines and lines that
+ * start with '#' are skipped).  Any puzzle files given on the command line
+ * come first.  Returns false if the list could not be read.
+ */
+
+bool loadPuzzleList(SBP_OPTIONS *options) {
+
+  int   i = 0;
+  int   capacity = 0;
+  int   first_listed = 0;
+  size_t length = 0;
+  size_t line_capacity = 0;
+  char *line = NULL;
+  char *name = NULL;
+  char  path[FILENAME_MAX];
+  char **command_line_files = options->file_names;
+  int   num_command_line_files = options->num_files;
+  struct stat list_stat;
+  struct dirent *entry = NULL;
+  DIR  *directory = NULL;
+  FILE *manifest = NULL;
+
+  if (stat(options->puzzle_list, &list_stat) != 0) {
+    fprintf(stderr, "Could not read puzzle list: %s\n", options->puzzle_list);
+    return false;
+  }
+
+  /* Start from the puzzle files on the command line (not the default one) */
+  options->file_names = NULL;
+  options->num_files  = 0;
+  if (command_line_files != default_file_names) {
+    for (i = 0; i < num_command_line_files; i++) {
+      addPuzzleFile(options, &capacity, command_line_files[i]);
+    }
+  }
+  first_listed = options->num_files;
+
+  if (S_ISDIR(list_stat.st_mode)) {
+
+    directory = opendir(options->puzzle_list);
+    if (directory == NULL) {
+      fprintf(stderr, "Could not read puzzle list: %s\n", options->puzzle_list);
+      return false;
+    }
+    while ((entry = readdir(directory)) != NULL) {
+      length = strlen(entry->d_name);
+      if (length > 4 && strcmp(&entry->d_name[length - 4], ".txt") == 0) {
+        snprintf(path, sizeof(path), "%s/%s", options->puzzle_list, entry->d_name);
+        addPuzzleFile(options, &capacity, path);
+      }
+    }
+    closedir(directory);
+
+    if (options->num_files > first_listed) {
+      qsort(&options->file_names[first_listed], options->num_files - first_listed, sizeof(char *),
+            comparePuzzleNames);
+    }
+  }
+  else
+  {
+
+    manifest = fopen(options->puzzle_list, "r");
+    if (manifest == NULL) {
+      fprintf(stderr, "Could not read puzzle list: %s\n", options->puzzle_list);
+      return false;
+    }
+    while (getline(&line, &line_capacity, manifest) != -1) {
+      length = strlen(line);
+      while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r' ||
+                            line[length - 1] == ' ' || line[length - 1] == '\t')) {
+        line[--length] = '\0';
+      }
+      name = line;
+      while (*name == ' ' || *name == '\t') {
+        name++;
+      }
+      if (*name != '\0' && *name != '#') {
+        addPuzzleFile(options, &capacity, name);
+      }
+    }
+    free(line);
+    fclose(manifest);
+  }
+
+  if (options->num_files == 0) {
+    fprintf(stderr, "No puzzle files in puzzle list: %s\n", options->puzzle_list);
+    return false;
+  }
+
+  return true;
+
+}
+
+
+/**
+ * Function: printPuzzleOutput
+ *
+ * Prints the <output> collected while solving one puzzle (of <output_size>
+ * bytes), after the output of the puzzles before it.  In a pool of worker
+ * threads, the caller holds the pool's lock.
+ */
+
+static void printPuzzleOutput(SBP_OPTIONS *options, char *output, size_t output_size) {
+
+  /* JSON objects from different puzzles need a separator */
+  if (output_size > 0) {
+    if (options->output_format == JSON_OUTPUT && num_results_printed > 0) {
+      printf(",\n");
+    }
+    fwrite(output, 1, output_size, stdout);
+    fflush(stdout);
+    num_results_printed++;
+  }
+
+}
+
+
+/**
+ * Function: startWorker
+ *
+ * Forks a worker process that solves the puzzle in <file_name> (writing its
+ * output into a pipe), and fills in the <worker>.
+ */
+
+static void startWorker(SBP_OPTIONS *options, BATCH_WORKER *worker, char *file_name) {
+
+  int pipe_fds[2];
+
+  fflush(stdout);
+  if (pipe(pipe_fds) != 0) {
+    perror("pipe");
+    exit(EXIT_FAILURE);
+  }
+
+  worker->pid = fork();
+  if (worker->pid < 0) {
+    perror("fork");
+    exit(EXIT_FAILURE);
+  }
+
+  /* Worker: solve the puzzle, with stdout going into the pipe (its results
+     are numbered from the start, as the separators are put in here) */
+  if (worker->pid == 0) {
+    close(pipe_fds[0]);
+    dup2(pipe_fds[1], STDOUT_FILENO);
+    close(pipe_fds[1]);
+    num_results_printed = 0;
+    solvePuzzle(options, file_name, stdout, &num_results_printed);
+    fflush(stdout);
+    _exit(0);
+  }
+
+  close(pipe_fds[1]);
+  worker->fd = pipe_fds[0];
+  worker->file_name = file_name;
+  worker->output_size = 0;
+
+}
+
+
+/**
+ * Function: finishWorker
+ *
+ * Waits for the <worker> to exit, and prints its output (or reports that it
+ * failed).  Frees up the worker's slot.
+ */
+
+static void finishWorker(SBP_OPTIONS *options, BATCH_WORKER *worker) {
+
+  int status = 0;
+
+  close(worker->fd);
+  waitpid(worker->pid, &status, 0);
+
+  printPuzzleOutput(options, worker->output, worker->output_size);
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fprintf(stderr, "Solver for %s did not finish (status %d).\n", worker->file_name, status);
+  }
+
+  worker->pid = 0;
+
+}
+
+
+/**
+ * Function: runIsolatedBatch
+ *
+ * Solves every puzzle file in <options> with every selected search, with up to
+ * options->num_jobs worker processes at a time, and prints each puzzle's
+ * results as soon as it is solved.
+ */
+
+static void runIsolatedBatch(SBP_OPTIONS *options) {
+
+  int i = 0;
+  int next_file = 0;
+  int num_running = 0;
+  int num_polled = 0;
+  ssize_t bytes_read = 0;
+  BATCH_WORKER *worker = NULL;
+  BATCH_WORKER *workers = calloc(options->num_jobs, sizeof(BATCH_WORKER));
+  struct pollfd *poll_fds = calloc(options->num_jobs, sizeof(struct pollfd));
+  int *poll_workers = calloc(options->num_jobs, sizeof(int));
+
+  if (workers == NULL || poll_fds == NULL || poll_workers == NULL) {
+    fprintf(stderr, "Out of memory (batch solver).\n");
+    exit(EXIT_FAILURE);
+  }
+
+  while (next_file < options->num_files || num_running > 0) {
+
+    /* Keep every worker slot busy */
+    for (i = 0; i < options->num_jobs && next_file < options->num_files; i++) {
+      if (workers[i].pid == 0) {
+        startWorker(options, &workers[i], options->file_names[next_file++]);
+        num_running++;
+      }
+    }
+
+    /* Wait for output from any of the workers */
+    num_polled = 0;
+    for (i = 0; i < options->num_jobs; i++) {
+      if (workers[i].pid != 0) {
+        poll_fds[num_polled].fd = workers[i].fd;
+        poll_fds[num_polled].events = POLLIN;
+        poll_workers[num_polled++] = i;
+      }
+    }
+    if (poll(poll_fds, num_polled, -1) < 0) {
+      continue;
+    }
+
+    for (i = 0; i < num_polled; i++) {
+
+      worker = &workers[poll_workers[i]];
+      if ((poll_fds[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+        continue;
+      }
+
+      /* Grow the output buffer (if there is not room for another read) */
+      if (worker->output_capacity - worker->output_size < BATCH_READ_SIZE) {
+        worker->output_capacity = worker->output_capacity * 2 + BATCH_READ_SIZE;
+        worker->output = realloc(worker->output, worker->output_capacity);
+        if (worker->output == NULL) {
+          fprintf(stderr, "Out of memory (batch solver).\n");
+          exit(EXIT_FAILURE);
+        }
+      }
+
+      bytes_read = read(worker->fd, &worker->output[worker->output_size], BATCH_READ_SIZE);
+      if (bytes_read > 0) {
+        worker->output_size += bytes_read;
+      }
+      else
+      {
+        finishWorker(options, worker);
+        num_running--;
+      }
+    }
+  }
+
+  for (i = 0; i < options->num_jobs; i++) {
+    free(workers[i].output);
+  }
+  free(workers);
+  free(poll_fds);
+  free(poll_workers);
+
+}
+
+
+/**
+ * Function: batchWorkerThread
+ *
+ * Worker Thread of the <pool>: solves the next puzzle on the list (with a
+ * Solver Context of its own, and its output going into a memory buffer), and
+ * prints its output, until every puzzle is taken.
+ */
+
+static void *batchWorkerThread(void *pool_ptr) {
+
+  int    file_index = 0;
+  int    num_results = 0;
+  char  *output = NULL;
+  size_t output_size = 0;
+  FILE  *output_stream = NULL;
+  BATCH_POOL *pool = (BATCH_POOL *) pool_ptr;
+
+  while (true) {
+
+    /* Take the next Puzzle */
+    pthread_mutex_lock(&pool->lock);
+    file_index = pool->next_file;
+    if (file_index < pool->options->num_files) {
+      pool->next_file++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (file_index >= pool->options->num_files) {
+      break;
+    }
+
+    /* Solve it, collecting its output */
+    output = NULL;
+    output_size = 0;
+    num_results = 0;
+    output_stream = open_memstream(&output, &output_size);
+    if (output_stream == NULL) {
+      fprintf(stderr, "Out of memory (batch solver).\n");
+      exit(EXIT_FAILURE);
+    }
+    solvePuzzle(pool->options, pool->options->file_names[file_index], output_stream, &num_results);
+    fclose(output_stream);
+
+    pthread_mutex_lock(&pool->lock);
+    printPuzzleOutput(pool->options, output, output_size);
+    pthread_mutex_unlock(&pool->lock);
+
+    free(output);
+  }
+
+  return NULL;
+
+}
+
+
+/**
+ * Function: runBatch
+ *
+ * Solves every puzzle file in <options> with every selected search, with up to
+ * options->num_jobs worker threads (or, in isolation mode, worker processes)
+ * at a time, and prints each puzzle's results as soon as it is solved.
+ */
+
+void runBatch(SBP_OPTIONS *options) {
+
+  int i = 0;
+  BATCH_POOL pool;
+  pthread_t *threads = NULL;
+
+  if (options->isolate_jobs) {
+    runIsolatedBatch(options);
+    return;
+  }
+
+  threads = calloc(options->num_jobs, sizeof(pthread_t));
+  if (threads == NULL) {
+    fprintf(stderr, "Out of memory (batch solver).\n");
+    exit(EXIT_FAILURE);
+  }
+
+  pool.options = options;
+  pool.next_file = 0;
+  pthread_mutex_init(&pool.lock, NULL);
+
+  for (i = 0; i < options->num_jobs; i++) {
+    pthread_create(&threads[i], NULL, batchWorkerThread, &pool);
+  }
+  for (i = 0; i < options->num_jobs; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  pthread_mutex_destroy(&pool.lock);
+  free(threads);
+
+}
@@ -4,15 +4,17 @@
 * DESCRIPTION :
 *
 *       Implements a First-in-First-Out (FIFO) queue for use in the BFS algorith.
-*       Note that the nodes in the queue contain information about their board_state
-*       parent board_state, and move from the parent to the current board state.
+*       Note that the nodes in the queue contain their board_state, path cost, and
+*       the index of the state in the search's Path Store (which is how the path
+*       to the state is found).  The nodes are allocated from the search's arena,
+*       and the BFS gives each one back to the arena once it is expanded.
 *
 * PUBLIC FUNCTIONS :
 *
-*       void bfsEnqueue(int **board_state, MOVE *input_move, STATE_NODE *parent)
-*       STATE_NODE* bfsDequeue()
-*       bool bfsQueueIsEmpty()
-*       void drainQueue()
+*       void bfsEnqueue(BFS_QUEUE *queue, ARENA *arena, BOARD *board_state, int path_cost, int path_index)
+*       STATE_NODE* bfsDequeue(BFS_QUEUE *queue)
+*       bool bfsQueueIsEmpty(BFS_QUEUE *queue)
+*       void drainQueue(BFS_QUEUE *queue)
 *
 * AUTHOR : Philip Cheng
 * DATE   : 18 October 2017
@@ -20,49 +22,46 @@
 ************************************************************************/
 
 
-/* Head and Tail of the BFS FIFO Queue */
-STATE_NODE *bfs_fifo_head = NULL;
-STATE_NODE *bfs_fifo_tail = NULL;
+/* BFS FIFO Queue: its Head and Tail */
+typedef struct BFS_QUEUE {
+    STATE_NODE *head;
+    STATE_NODE *tail;
+} BFS_QUEUE;
 
 
 /**
  * Function: bfsEnqueue
  *
- * Creates a State Node with the given information (board_state, move, and
- * parent) and inserts the Node into the FIFO Queue, at the TAIL end.
+ * Creates a State Node (in the <arena>) with a copy of the given information
+ * (board_state, path cost, and Path Store index) and inserts the Node into the
+ * FIFO <queue>, at the TAIL end.
  */
 
-void bfsEnqueue(int **board_state, MOVE *input_move, STATE_NODE *parent) {
+void bfsEnqueue(BFS_QUEUE *queue, ARENA *arena, BOARD *board_state, int path_cost, int path_index) {
 
   /* Create the new State Node */
-  STATE_NODE *new_node = malloc(sizeof(STATE_NODE));
-  new_node->board_state = board_state;
-  new_node->move_from_parent = input_move;
-  new_node->parent = parent;
+  STATE_NODE *new_node = arenaAllocNode(arena);
+  new_node->board_state = *board_state;
+  new_node->move_from_parent = 0;
+  new_node->parent = NULL;
+  new_node->path_index = path_index;
+  new_node->path_cost = path_cost;
+  new_node->heuristic = 0;
   new_node->next = NULL;
 
-  /* Update Path Cost (for Depth Limited Search) */
-  if (parent != NULL) {
-    new_node->path_cost = parent->path_cost + 1;
-  }
-  else
-  {
-    new_node->path_cost = 0;
-  }
-
   /* Update Head if First Insertion */
-  if (bfs_fifo_head == NULL){
-    bfs_fifo_head = new_node;
+  if (queue->head == NULL){
+    queue->head = new_node;
   }
 
   /* Update Tail */
-  if (bfs_fifo_tail == NULL){
-    bfs_fifo_tail = new_node;
+  if (queue->tail == NULL){
+    queue->tail = new_node;
   }
   else
   {
-    bfs_fifo_tail->next = new_node;
-    bfs_fifo_tail = new_node;
+    queue->tail->next = new_node;
+    queue->tail = new_node;
   }
 
 }
@@ -71,14 +70,20 @@ void bfsEnqueue(int **board_state, MOVE *input_move, STATE_NODE *parent) {
 /**
  * Function: bfsDequeue
  *
- * Dequeues and returns a pointer to the State Node at the HEAD of the FIFO Queue.
+ * Dequeues and returns a pointer to the State Node at the HEAD of the FIFO <queue>.
  */
 
-STATE_NODE* bfsDequeue() {
+STATE_NODE* bfsDequeue(BFS_QUEUE *queue) {
+
+  STATE_NODE *return_node = queue->head;
+  STATE_NODE *new_head = queue->head->next;
+  queue->head = new_head;
+
+  /* Update Tail if the Queue is now empty */
+  if (queue->head == NULL) {
+    queue->tail = NULL;
+  }
 
-  STATE_NODE *return_node = bfs_fifo_head;
-  STATE_NODE *new_head = bfs_fifo_head->next;
-  bfs_fifo_head = new_head;
   return return_node;
 
 }
@@ -87,22 +92,22 @@ STATE_NODE* bfsDequeue() {
 /**
  * Function: bfsQueueIsEmpty
  *
- * Returns true is the FIFO Queue is empty
+ * Returns true is the FIFO <queue> is empty
  */
 
-bool bfsQueueIsEmpty() {
-  return (bfs_fifo_head == NULL);
+bool bfsQueueIsEmpty(BFS_QUEUE *queue) {
+  return (queue->head == NULL);
 }
 
 
 /**
  * Function: drainQueue
  *
- * Provides a way to empty out the bfsQueue
+ * Provides a way to empty out the FIFO <queue> (the State Nodes themselves are
+ * released along with the search's arena).
  */
 
-void drainQueue() {
-  while(!bfsQueueIsEmpty()) {
-    bfsDequeue();
-  }
+void drainQueue(BFS_QUEUE *queue) {
+  queue->head = NULL;
+  queue->tail = NULL;
 }
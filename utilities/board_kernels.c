@@ -0,0 +1,142 @@
+/************************************************************************
+* FILENAME : board_kernels.c
+*
+* DESCRIPTION :
+*
+*       Implements the Board Kernels: the inner loops that every search runs
+*       for each state (move generation, moving a block, normalizing a state,
+*       and hashing a state), compiled once for each of the common board
+*       sizes, and once more for any board size.
+*
+*       The kernels are generated from board_kernels_template.c, which is
+*       included once per size (see board_kernels_sizes.c), and all of the
+*       sizes once per version of the board scans (AVX2, SSE2 and plain C, see
+*       board_simd.c), with the scans inlined.  When a puzzle is loaded, the
+*       kernels for its size (or the generic ones, if there are none), of the
+*       best version the CPU supports, are selected into its Solver Context,
+*       and the game functions call them from there.  So the version is picked
+*       once per puzzle, rather than on every scan.  The kernels of a fixed
+*       size have their loop bounds, rows and columns known at compile time,
+*       so the compiler can unroll their loops.
+*
+*       To specialize another board size, add an instance to
+*       board_kernels_sizes.c, and an entry for it in BOARD_KERNELS_TABLE.
+*
+* PUBLIC FUNCTIONS :
+*
+*       void selectBoardKernels(SOLVER_CONTEXT *ctx)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+/* Kernels of one board size (0 x 0 for the generic ones) */
+typedef struct BOARD_KERNELS {
+    int      width;
+    int      height;
+    int      (*getAllAvailableMoves)(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE *available_moves);
+    int      (*moveBlockCells)(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move, uint64_t *hashkey);
+    void     (*normalizeState)(SOLVER_CONTEXT *ctx, BOARD *input_state);
+    uint64_t (*getBoardHashKey)(SOLVER_CONTEXT *ctx, BOARD *input_state);
+} BOARD_KERNELS;
+
+/* Plain C Kernels */
+#define KERNEL_VERSION(name) name##_scalar
+#define KERNEL_TARGET
+#define KERNEL_CELLS_EQUAL_TO(board, value) scalarCellsEqualTo(board, value)
+#define KERNEL_CELLS_ABOVE(board, value)    scalarCellsAbove(board, value)
+#include "board_kernels_sizes.c"
+#undef KERNEL_VERSION
+#undef KERNEL_TARGET
+#undef KERNEL_CELLS_EQUAL_TO
+#undef KERNEL_CELLS_ABOVE
+
+/* SSE2 Kernels */
+#ifdef BOARD_SIMD_SSE2
+#define KERNEL_VERSION(name) name##_sse2
+#define KERNEL_TARGET
+#define KERNEL_CELLS_EQUAL_TO(board, value) sse2CellsEqualTo(board, value)
+#define KERNEL_CELLS_ABOVE(board, value)    sse2CellsAbove(board, value)
+#include "board_kernels_sizes.c"
+#undef KERNEL_VERSION
+#undef KERNEL_TARGET
+#undef KERNEL_CELLS_EQUAL_TO
+#undef KERNEL_CELLS_ABOVE
+#endif
+
+/* AVX2 Kernels (compiled for AVX2 as a whole, so the scans are inlined) */
+#ifdef BOARD_SIMD_AVX2
+#define KERNEL_VERSION(name) name##_avx2
+#define KERNEL_TARGET        __attribute__((target("avx2")))
+#define KERNEL_CELLS_EQUAL_TO(board, value) avx2CellsEqualTo(board, value)
+#define KERNEL_CELLS_ABOVE(board, value)    avx2CellsAbove(board, value)
+#include "board_kernels_sizes.c"
+#undef KERNEL_VERSION
+#undef KERNEL_TARGET
+#undef KERNEL_CELLS_EQUAL_TO
+#undef KERNEL_CELLS_ABOVE
+#endif
+
+/* Fills in a BOARD_KERNELS entry with the kernels of one size */
+#define BOARD_KERNELS_ENTRY(width, height, suffix) \
+  { width, height, getAllAvailableMoves##suffix, moveBlockCells##suffix, normalizeState##suffix, \
+    getBoardHashKey##suffix }
+
+/* Kernels of one version for each specialized board size (width x height),
+   then the generic ones (which must come last) */
+#define BOARD_KERNELS_TABLE(version) { \
+  BOARD_KERNELS_ENTRY(4, 5, _4x5##version), \
+  BOARD_KERNELS_ENTRY(5, 4, _5x4##version), \
+  BOARD_KERNELS_ENTRY(5, 5, _5x5##version), \
+  BOARD_KERNELS_ENTRY(6, 5, _6x5##version), \
+  BOARD_KERNELS_ENTRY(6, 6, _6x6##version), \
+  BOARD_KERNELS_ENTRY(6, 7, _6x7##version), \
+  BOARD_KERNELS_ENTRY(0, 0, _generic##version) \
+}
+
+/* Kernels of each version of the board scans */
+static const BOARD_KERNELS Board_Kernels_Scalar[] = BOARD_KERNELS_TABLE(_scalar);
+#ifdef BOARD_SIMD_SSE2
+static const BOARD_KERNELS Board_Kernels_Sse2[] = BOARD_KERNELS_TABLE(_sse2);
+#endif
+#ifdef BOARD_SIMD_AVX2
+static const BOARD_KERNELS Board_Kernels_Avx2[] = BOARD_KERNELS_TABLE(_avx2);
+#endif
+
+
+/**
+ * Function: selectBoardKernels
+ *
+ * Selects the Board Kernels for the board size of the puzzle loaded into the
+ * <ctx>: the kernels specialized for that size, or the generic ones.
+ */
+
+void selectBoardKernels(SOLVER_CONTEXT *ctx) {
+
+  int i = 0;
+  int num_kernels = sizeof(Board_Kernels_Scalar) / sizeof(BOARD_KERNELS);
+  const BOARD_KERNELS *board_kernels = Board_Kernels_Scalar;
+
+  /* Kernels of the best version of the board scans */
+#ifdef BOARD_SIMD_SSE2
+  if (getBoardSimdVersion() == SSE2_BOARD_SCANS) {
+    board_kernels = Board_Kernels_Sse2;
+  }
+#endif
+#ifdef BOARD_SIMD_AVX2
+  if (getBoardSimdVersion() == AVX2_BOARD_SCANS) {
+    board_kernels = Board_Kernels_Avx2;
+  }
+#endif
+
+  /* Kernels of the board size */
+  for (i = 0; i < num_kernels - 1; i++) {
+    if (board_kernels[i].width == ctx->board_width && board_kernels[i].height == ctx->board_height) {
+      break;
+    }
+  }
+
+  ctx->kernels = &board_kernels[i];
+
+}
@@ -0,0 +1,65 @@
+/************************************************************************
+* FILENAME : board_kernels_sizes.c
+*
+* DESCRIPTION :
+*
+*       Instances of the Board Kernels (board_kernels_template.c) for each of
+*       the common board sizes, and for any board size.  It is not compiled
+*       on its own, but included by board_kernels.c once for each version of
+*       the board scans, with these macros defined:
+*
+*         KERNEL_VERSION(name)  Name of a kernel of this version (e.g.
+*                               name##_avx2)
+*         KERNEL_TARGET         Attributes of the kernels of this version
+*         KERNEL_CELLS_EQUAL_TO(board, value), KERNEL_CELLS_ABOVE(board, value)
+*                               Board scans of this version
+*
+*       To specialize another board size, add an instance below, and an entry
+*       for it in BOARD_KERNELS_TABLE (see board_kernels.c).
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+/* Generic Kernels (any board size, as loaded into the ctx) */
+#define KERNEL_WIDTH      (ctx->board_width)
+#define KERNEL_HEIGHT     (ctx->board_height)
+#define KERNEL_NAME(name) KERNEL_VERSION(name##_generic)
+#include "board_kernels_template.c"
+
+/* 4 x 5 Kernels */
+#define KERNEL_WIDTH      4
+#define KERNEL_HEIGHT     5
+#define KERNEL_NAME(name) KERNEL_VERSION(name##_4x5)
+#include "board_kernels_template.c"
+
+/* 5 x 4 Kernels */
+#define KERNEL_WIDTH      5
+#define KERNEL_HEIGHT     4
+#define KERNEL_NAME(name) KERNEL_VERSION(name##_5x4)
+#include "board_kernels_template.c"
+
+/* 5 x 5 Kernels */
+#define KERNEL_WIDTH      5
+#define KERNEL_HEIGHT     5
+#define KERNEL_NAME(name) KERNEL_VERSION(name##_5x5)
+#include "board_kernels_template.c"
+
+/* 6 x 5 Kernels */
+#define KERNEL_WIDTH      6
+#define KERNEL_HEIGHT     5
+#define KERNEL_NAME(name) KERNEL_VERSION(name##_6x5)
+#include "board_kernels_template.c"
+
+/* 6 x 6 Kernels */
+#define KERNEL_WIDTH      6
+#define KERNEL_HEIGHT     6
+#define KERNEL_NAME(name) KERNEL_VERSION(name##_6x6)
+#include "board_kernels_template.c"
+
+/* 6 x 7 Kernels */
+#define KERNEL_WIDTH      6
+#define KERNEL_HEIGHT     7
+#define KERNEL_NAME(name) KERNEL_VERSION(name##_6x7)
+#include "board_kernels_template.c"
@@ -0,0 +1,317 @@
+/************************************************************************
+* FILENAME : board_kernels_template.c
+*
+* DESCRIPTION :
+*
+*       Body of the Board Kernels: the inner loops of move generation, moving
+*       a block, normalizing a state, and hashing a state.  It is not compiled
+*       on its own, but included (through board_kernels_sizes.c) once for each
+*       board size it is specialized for, and each version of the board scans,
+*       with these macros defined:
+*
+*         KERNEL_WIDTH       Columns on the board
+*         KERNEL_HEIGHT      Rows on the board
+*         KERNEL_NAME(name)  Name of a kernel of this size and version (e.g.
+*                            name##_6x7_avx2)
+*         KERNEL_TARGET      Attributes of the kernels of this version (e.g.
+*                            the instruction set they are compiled for)
+*         KERNEL_CELLS_EQUAL_TO(board, value), KERNEL_CELLS_ABOVE(board, value)
+*                            Board scans of this version (see board_simd.c)
+*
+*       With KERNEL_WIDTH and KERNEL_HEIGHT defined as constants, every loop
+*       bound, and every row and column, is known at compile time (so the
+*       loops can be unrolled, and the divisions are folded away).  The generic
+*       kernels define them as the board size in the <ctx>.  Every kernel
+*       takes the <ctx>, so the generic ones can get at the board size.
+*
+*       Moving a block, and hashing, start from a vectorized scan of the board
+*       (see board_simd.c), rather than a loop over its cells.  The scans are
+*       inlined, so the kernels never make an indirect call to scan a board.
+*
+*       The size macros are undefined at the end, ready for the next size.
+*
+* KERNELS :
+*
+*       int      KERNEL_NAME(getBlockedDirections)(SOLVER_CONTEXT *ctx, BOARD *input_state, int cell,
+*                                                  int piece_num)
+*       int      KERNEL_NAME(getAllAvailableMoves)(SOLVER_CONTEXT *ctx, BOARD *input_state,
+*                                                  MOVE *available_moves)
+*       int      KERNEL_NAME(moveBlockCells)(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move,
+*                                            uint64_t *hashkey)
+*       void     KERNEL_NAME(normalizeState)(SOLVER_CONTEXT *ctx, BOARD *input_state)
+*       uint64_t KERNEL_NAME(getBoardHashKey)(SOLVER_CONTEXT *ctx, BOARD *input_state)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+/* Number of cells on the board */
+#define KERNEL_CELLS (KERNEL_WIDTH * KERNEL_HEIGHT)
+
+
+/**
+ * Function: getBlockedDirections
+ *
+ * Checks the four cells adjacent to cell # <cell> (which is covered by block #
+ * <piece_num>) and returns a bitmask (1 << Move_Direction) of the directions
+ * in which this cell keeps the block from moving.  A block can move into empty
+ * cells (or its own cells), and only the master brick can move onto the goal.
+ */
+
+KERNEL_TARGET
+static inline int KERNEL_NAME(getBlockedDirections)(SOLVER_CONTEXT *ctx, BOARD *input_state, int cell,
+                                                    int piece_num) {
+
+  int row = cell / KERNEL_WIDTH;
+  int col = cell % KERNEL_WIDTH;
+  int blocked = 0;
+  int neighbor = 0;
+
+  (void) ctx;  /* only the generic kernel reads the board size from the <ctx> */
+
+  /* Check if Up Direction is a Legal Move */
+  if (row == 0) {
+    blocked |= (1 << UP);
+  }
+  else
+  {
+    neighbor = input_state->cells[cell - KERNEL_WIDTH];
+    if (neighbor != 0 && neighbor != piece_num && (piece_num != 2 || neighbor != -1)) {
+      blocked |= (1 << UP);
+    }
+  }
+
+  /* Check Down Direction */
+  if (row == KERNEL_HEIGHT - 1) {
+    blocked |= (1 << DOWN);
+  }
+  else
+  {
+    neighbor = input_state->cells[cell + KERNEL_WIDTH];
+    if (neighbor != 0 && neighbor != piece_num && (piece_num != 2 || neighbor != -1)) {
+      blocked |= (1 << DOWN);
+    }
+  }
+
+  /* Check Left Direction */
+  if (col == 0) {
+    blocked |= (1 << LEFT);
+  }
+  else
+  {
+    neighbor = input_state->cells[cell - 1];
+    if (neighbor != 0 && neighbor != piece_num && (piece_num != 2 || neighbor != -1)) {
+      blocked |= (1 << LEFT);
+    }
+  }
+
+  /* Check Right Direction */
+  if (col == KERNEL_WIDTH - 1) {
+    blocked |= (1 << RIGHT);
+  }
+  else
+  {
+    neighbor = input_state->cells[cell + 1];
+    if (neighbor != 0 && neighbor != piece_num && (piece_num != 2 || neighbor != -1)) {
+      blocked |= (1 << RIGHT);
+    }
+  }
+
+  return blocked;
+
+}
+
+
+/**
+ * Function: getAllAvailableMoves
+ *
+ * Searches the <input_state> for all possible legal moves generated by moving
+ * any moveable block in the game state, in a single pass over the board.
+ * Writes the moves into <available_moves> (room for MAX_AVAILABLE_MOVES),
+ * ordered by block number, and returns the number of moves.
+ */
+
+KERNEL_TARGET
+static int KERNEL_NAME(getAllAvailableMoves)(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE *available_moves) {
+
+  int  i = 0;
+  int  num_total_available_moves = 0;
+  int  block_num = 0;
+  int  highest_block = 0;
+  Move_Direction direction = UP;
+
+  /* Blocked directions (and presence) of each block on the board */
+  uint8_t blocked[MAX_BLOCK_NUM + 1];
+  bool    block_present[MAX_BLOCK_NUM + 1];
+
+  memset(blocked, 0, sizeof(blocked));
+  memset(block_present, 0, sizeof(block_present));
+
+  /* Single pass: collect the blocked directions of every block */
+  for (i = 0; i < KERNEL_CELLS; i++) {
+    block_num = input_state->cells[i];
+    if (block_num >= 2) {
+      block_present[block_num] = true;
+      blocked[block_num] |= KERNEL_NAME(getBlockedDirections)(ctx, input_state, i, block_num);
+      if (block_num > highest_block) {
+        highest_block = block_num;
+      }
+    }
+  }
+
+  /* Write out the moves of every block that is not blocked */
+  for (block_num = 2; block_num <= highest_block; block_num++) {
+    if (block_present[block_num]) {
+      for (direction = UP; direction <= RIGHT; direction++) {
+        if (!(blocked[block_num] & (1 << direction))) {
+          available_moves[num_total_available_moves].block_num = block_num;
+          available_moves[num_total_available_moves].direction = direction;
+          num_total_available_moves++;
+        }
+      }
+    }
+  }
+
+  return num_total_available_moves;
+
+}
+
+
+/**
+ * Function: moveBlockCells
+ *
+ * Moves block # <move.block_num> one cell in the <move>'s direction, rewriting
+ * only the cells that change: the cells in front of the block (its leading
+ * edge) get the block, and the cells it leaves behind (its trailing edge) get
+ * the Board Layout back.  If <hashkey> is not NULL, the Zobrist hash is updated
+ * for each cell that changes.  Returns the block's first (top-left most) cell
+ * before the move.
+ */
+
+KERNEL_TARGET
+static int KERNEL_NAME(moveBlockCells)(SOLVER_CONTEXT *ctx, BOARD *input_state, MOVE move, uint64_t *hashkey) {
+
+  int i,j = 0;
+  int row_delta = Move_Row_Deltas[move.direction];
+  int col_delta = Move_Col_Deltas[move.direction];
+  int row, col = 0;
+  int first_cell = -1;
+  uint64_t block_cells = KERNEL_CELLS_EQUAL_TO(input_state, move.block_num) & boardCellsMask(KERNEL_CELLS);
+
+  int leading_edge[MAX_BOARD_CELLS];
+  int trailing_edge[MAX_BOARD_CELLS];
+  int num_leading = 0;
+  int num_trailing = 0;
+
+  /* Find the leading and trailing edges of the moving block (visiting just
+     its cells, from the top-left) */
+  if (block_cells != 0) {
+    first_cell = __builtin_ctzll(block_cells);
+  }
+  while (block_cells != 0) {
+
+    i = __builtin_ctzll(block_cells);
+    block_cells &= block_cells - 1;
+
+    j = i + row_delta * KERNEL_WIDTH + col_delta;
+    if (input_state->cells[j] != move.block_num) {
+      leading_edge[num_leading++] = j;
+    }
+
+    row = i / KERNEL_WIDTH - row_delta;
+    col = i % KERNEL_WIDTH - col_delta;
+    if (row < 0 || row >= KERNEL_HEIGHT || col < 0 || col >= KERNEL_WIDTH ||
+        input_state->cells[row * KERNEL_WIDTH + col] != move.block_num) {
+      trailing_edge[num_trailing++] = i;
+    }
+  }
+
+  /* Uncover the Board Layout behind the block, and cover the cells in front */
+  for (i = 0; i < num_trailing; i++) {
+    j = trailing_edge[i];
+    if (hashkey != NULL) {
+      *hashkey = updateStateHashKey(&ctx->keys, *hashkey, j, move.block_num, ctx->board_layout.cells[j]);
+    }
+    input_state->cells[j] = ctx->board_layout.cells[j];
+  }
+
+  for (i = 0; i < num_leading; i++) {
+    j = leading_edge[i];
+    if (hashkey != NULL) {
+      *hashkey = updateStateHashKey(&ctx->keys, *hashkey, j, input_state->cells[j], move.block_num);
+    }
+    input_state->cells[j] = move.block_num;
+  }
+
+  return first_cell;
+
+}
+
+
+/**
+ * Function: normalizeState
+ *
+ * "Normalizes" an <input_state>, by renumbering block numbers > 2 with new block
+ * numbers arranged in incrementing numbers from the top-left to the bottom-right.
+ */
+
+KERNEL_TARGET
+static void KERNEL_NAME(normalizeState)(SOLVER_CONTEXT *ctx, BOARD *input_state) {
+
+  int i = 0;
+  int    block_num = 0;
+  int8_t remap[MAX_BLOCK_NUM + 1] = {0};
+  int    remap_counter = 3;
+
+  (void) ctx;  /* only the generic kernel reads the board size from the <ctx> */
+
+  /* Create Re-map Plan (a block is "seen" once it has a non-zero remap) */
+  for (i = 0; i < KERNEL_CELLS; i++) {
+    block_num = input_state->cells[i];
+    if (block_num > 2 && remap[block_num] == 0) {
+      remap[block_num] = remap_counter++;
+    }
+  }
+
+  /* Re-map, to create Normalized State */
+  for (i = 0; i < KERNEL_CELLS; i++) {
+    if (input_state->cells[i] > 2) {
+      input_state->cells[i] = remap[input_state->cells[i]];
+    }
+  }
+
+}
+
+
+/**
+ * Function: getBoardHashKey
+ *
+ * Calculates the 64-bit Zobrist Hash Key of an <input_state> (the same hash
+ * as getStateHashKey, with the key layout of the <ctx>).  Only the cells
+ * covered by bricks are visited, since the other cells hash to 0.
+ */
+
+KERNEL_TARGET
+static uint64_t KERNEL_NAME(getBoardHashKey)(SOLVER_CONTEXT *ctx, BOARD *input_state) {
+
+  int i = 0;
+  uint64_t hashkey = 0;
+  uint64_t brick_cells = KERNEL_CELLS_ABOVE(input_state, 1) & boardCellsMask(KERNEL_CELLS);
+
+  while (brick_cells != 0) {
+    i = __builtin_ctzll(brick_cells);
+    brick_cells &= brick_cells - 1;
+    hashkey ^= zobrist_keys[i][ctx->keys.block_class[input_state->cells[i]]];
+  }
+
+  return hashkey;
+
+}
+
+
+/* Ready for the next board size */
+#undef KERNEL_CELLS
+#undef KERNEL_WIDTH
+#undef KERNEL_HEIGHT
+#undef KERNEL_NAME
@@ -0,0 +1,364 @@
+/************************************************************************
+* FILENAME : board_simd.c
+*
+* DESCRIPTION :
+*
+*       Implements the vectorized board scans that the Board Kernels run on
+*       every generated state: finding the cells of a board that hold a given
+*       value (e.g. the cells of one brick), finding the cells that hold
+*       bricks, and comparing two boards.  A BOARD is 64 bytes, one byte per
+*       cell, so each scan is a few vector compares, and the result is a
+*       bitmask with one bit per cell (bit i for cell # i).
+*
+*       There are three versions of the scans: AVX2 (two 32-byte compares per
+*       board), SSE2 (four 16-byte compares), and a plain C fallback.  The best
+*       version the CPU supports is found the first time initBoardSimd is
+*       called.  The Board Kernels are compiled once for each version, with
+*       its scans inlined, and selectBoardKernels picks the kernels of the
+*       version that was found, so the hot loops never dispatch per call.
+*       Code outside the kernels uses the best version that every CPU this
+*       was compiled for supports (SSE2 on x86-64, otherwise the fallback).
+*       Build with -DNO_BOARD_SIMD to always use the fallback (e.g. to compare
+*       the versions).
+*
+*       The scans cover all MAX_BOARD_CELLS cells, so callers mask off the
+*       cells past the end of the board with boardCellsMask.
+*
+* PUBLIC FUNCTIONS :
+*
+*       void     initBoardSimd()
+*       Board_Simd_Version getBoardSimdVersion()
+*       uint64_t boardCellsMask(int num_cells)
+*       uint64_t boardCellsEqualTo(BOARD *board, int8_t value)
+*       uint64_t boardCellsAbove(BOARD *board, int8_t value)
+*       bool     boardsEqual(BOARD *board_a, BOARD *board_b)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+#include <pthread.h>
+
+/* Versions of the scans that this compiler can build */
+#if !defined(NO_BOARD_SIMD) && defined(__SSE2__)
+#define BOARD_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+#if !defined(NO_BOARD_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BOARD_SIMD_AVX2 1
+#include <immintrin.h>
+#endif
+
+/* Versions of the board scans */
+typedef enum {SCALAR_BOARD_SCANS, SSE2_BOARD_SCANS, AVX2_BOARD_SCANS} Board_Simd_Version;
+
+
+/**
+ * Function: scalarCellsEqualTo
+ *
+ * Returns a bitmask of the cells of the <board> that hold <value> (plain C).
+ */
+
+static inline uint64_t scalarCellsEqualTo(BOARD *board, int8_t value) {
+
+  int i = 0;
+  uint64_t mask = 0;
+
+  for (i = 0; i < MAX_BOARD_CELLS; i++) {
+    if (board->cells[i] == value) {
+      mask |= (uint64_t) 1 << i;
+    }
+  }
+
+  return mask;
+
+}
+
+
+/**
+ * Function: scalarCellsAbove
+ *
+ * Returns a bitmask of the cells of the <board> that hold more than <value>
+ * (plain C).
+ */
+
+static inline uint64_t scalarCellsAbove(BOARD *board, int8_t value) {
+
+  int i = 0;
+  uint64_t mask = 0;
+
+  for (i = 0; i < MAX_BOARD_CELLS; i++) {
+    if (board->cells[i] > value) {
+      mask |= (uint64_t) 1 << i;
+    }
+  }
+
+  return mask;
+
+}
+
+
+/**
+ * Function: scalarBoardsEqual
+ *
+ * Returns true if <board_a> and <board_b> are equal (plain C, a word at a time).
+ */
+
+static inline bool scalarBoardsEqual(BOARD *board_a, BOARD *board_b) {
+
+  int i = 0;
+
+  for (i = 0; i < BOARD_WORDS; i++) {
+    if (board_a->words[i] != board_b->words[i]) {
+      return false;
+    }
+  }
+  return true;
+
+}
+
+#ifdef BOARD_SIMD_SSE2
+
+/**
+ * Function: sse2CellsEqualTo
+ *
+ * Returns a bitmask of the cells of the <board> that hold <value> (SSE2).
+ */
+
+static inline uint64_t sse2CellsEqualTo(BOARD *board, int8_t value) {
+
+  int i = 0;
+  uint64_t mask = 0;
+  __m128i  values = _mm_set1_epi8(value);
+  __m128i  cells;
+
+  for (i = 0; i < MAX_BOARD_CELLS; i += 16) {
+    cells = _mm_loadu_si128((const __m128i *) &board->cells[i]);
+    mask |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(cells, values)) << i;
+  }
+
+  return mask;
+
+}
+
+
+/**
+ * Function: sse2CellsAbove
+ *
+ * Returns a bitmask of the cells of the <board> that hold more than <value>
+ * (SSE2).
+ */
+
+static inline uint64_t sse2CellsAbove(BOARD *board, int8_t value) {
+
+  int i = 0;
+  uint64_t mask = 0;
+  __m128i  values = _mm_set1_epi8(value);
+  __m128i  cells;
+
+  for (i = 0; i < MAX_BOARD_CELLS; i += 16) {
+    cells = _mm_loadu_si128((const __m128i *) &board->cells[i]);
+    mask |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpgt_epi8(cells, values)) << i;
+  }
+
+  return mask;
+
+}
+
+
+/**
+ * Function: sse2BoardsEqual
+ *
+ * Returns true if <board_a> and <board_b> are equal (SSE2).
+ */
+
+static inline bool sse2BoardsEqual(BOARD *board_a, BOARD *board_b) {
+
+  int i = 0;
+  __m128i equal = _mm_set1_epi8(-1);
+
+  for (i = 0; i < MAX_BOARD_CELLS; i += 16) {
+    equal = _mm_and_si128(equal, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) &board_a->cells[i]),
+                                                 _mm_loadu_si128((const __m128i *) &board_b->cells[i])));
+  }
+
+  return _mm_movemask_epi8(equal) == 0xFFFF;
+
+}
+
+#endif
+
+#ifdef BOARD_SIMD_AVX2
+
+/**
+ * Function: avx2CellsEqualTo
+ *
+ * Returns a bitmask of the cells of the <board> that hold <value> (AVX2).
+ */
+
+__attribute__((target("avx2")))
+static inline uint64_t avx2CellsEqualTo(BOARD *board, int8_t value) {
+
+  __m256i values = _mm256_set1_epi8(value);
+  __m256i low    = _mm256_loadu_si256((const __m256i *) &board->cells[0]);
+  __m256i high   = _mm256_loadu_si256((const __m256i *) &board->cells[32]);
+
+  return (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, values)) |
+         (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, values)) << 32;
+
+}
+
+
+/**
+ * Function: avx2CellsAbove
+ *
+ * Returns a bitmask of the cells of the <board> that hold more than <value>
+ * (AVX2).
+ */
+
+__attribute__((target("avx2")))
+static inline uint64_t avx2CellsAbove(BOARD *board, int8_t value) {
+
+  __m256i values = _mm256_set1_epi8(value);
+  __m256i low    = _mm256_loadu_si256((const __m256i *) &board->cells[0]);
+  __m256i high   = _mm256_loadu_si256((const __m256i *) &board->cells[32]);
+
+  return (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpgt_epi8(low, values)) |
+         (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpgt_epi8(high, values)) << 32;
+
+}
+
+
+/**
+ * Function: avx2BoardsEqual
+ *
+ * Returns true if <board_a> and <board_b> are equal (AVX2).
+ */
+
+__attribute__((target("avx2")))
+static inline bool avx2BoardsEqual(BOARD *board_a, BOARD *board_b) {
+
+  __m256i low  = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) &board_a->cells[0]),
+                                  _mm256_loadu_si256((const __m256i *) &board_b->cells[0]));
+  __m256i high = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) &board_a->cells[32]),
+                                  _mm256_loadu_si256((const __m256i *) &board_b->cells[32]));
+
+  return _mm256_testz_si256(_mm256_or_si256(low, high), _mm256_or_si256(low, high));
+
+}
+
+#endif
+
+/* Best version of the Board Scans that the CPU supports, and whether it has
+   been found yet */
+static Board_Simd_Version board_simd_version = SCALAR_BOARD_SCANS;
+static pthread_once_t     board_simd_once = PTHREAD_ONCE_INIT;
+
+
+/**
+ * Function: findBoardSimdVersion
+ *
+ * Finds the best version of the board scans that the CPU supports.
+ */
+
+static void findBoardSimdVersion() {
+
+#ifdef BOARD_SIMD_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    board_simd_version = AVX2_BOARD_SCANS;
+    return;
+  }
+#endif
+
+#ifdef BOARD_SIMD_SSE2
+  board_simd_version = SSE2_BOARD_SCANS;
+#endif
+
+}
+
+
+/**
+ * Function: initBoardSimd
+ *
+ * Finds the version of the board scans to use, the first time it is called
+ * (from any thread).
+ */
+
+void initBoardSimd() {
+  pthread_once(&board_simd_once, findBoardSimdVersion);
+}
+
+
+/**
+ * Function: getBoardSimdVersion
+ *
+ * Returns the best version of the board scans that the CPU supports (once
+ * initBoardSimd has been called; the plain C version until then).
+ */
+
+Board_Simd_Version getBoardSimdVersion() {
+  return board_simd_version;
+}
+
+
+/**
+ * Function: boardCellsMask
+ *
+ * Returns a bitmask of the first <num_cells> cells, i.e. the cells of a board
+ * with <num_cells> cells.
+ */
+
+static inline uint64_t boardCellsMask(int num_cells) {
+  return (num_cells >= MAX_BOARD_CELLS) ? ~(uint64_t) 0 : ((uint64_t) 1 << num_cells) - 1;
+}
+
+
+/**
+ * Function: boardCellsEqualTo
+ *
+ * Returns a bitmask of the cells of the <board> that hold <value> (with the
+ * scans of the CPUs this was compiled for, outside the Board Kernels).
+ */
+
+static inline uint64_t boardCellsEqualTo(BOARD *board, int8_t value) {
+#ifdef BOARD_SIMD_SSE2
+  return sse2CellsEqualTo(board, value);
+#else
+  return scalarCellsEqualTo(board, value);
+#endif
+}
+
+
+/**
+ * Function: boardCellsAbove
+ *
+ * Returns a bitmask of the cells of the <board> that hold more than <value>
+ * (e.g. the cells covered by bricks, for a <value> of 1), with the scans of
+ * the CPUs this was compiled for, outside the Board Kernels.
+ */
+
+static inline uint64_t boardCellsAbove(BOARD *board, int8_t value) {
+#ifdef BOARD_SIMD_SSE2
+  return sse2CellsAbove(board, value);
+#else
+  return scalarCellsAbove(board, value);
+#endif
+}
+
+
+/**
+ * Function: boardsEqual
+ *
+ * Returns true if <board_a> and <board_b> are equal, cell for cell (with the
+ * scans of the CPUs this was compiled for, outside the Board Kernels).
+ */
+
+static inline bool boardsEqual(BOARD *board_a, BOARD *board_b) {
+#ifdef BOARD_SIMD_SSE2
+  return sse2BoardsEqual(board_a, board_b);
+#else
+  return scalarBoardsEqual(board_a, board_b);
+#endif
+}
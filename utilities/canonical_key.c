@@ -0,0 +1,370 @@
+/************************************************************************
+* FILENAME : canonical_key.c
+*
+* DESCRIPTION :
+*
+*       Implements the canonical key of a game state, which is what the closed
+*       sets store and compare instead of whole (normalized) boards.
+*
+*       When a puzzle is loaded, every brick is put into a shape class: the
+*       master brick is class 1 on its own, and the other bricks share a class
+*       if (and only if) they have the same shape.  The board is then fully
+*       described by where each class's bricks are, i.e. by the set of first
+*       (top-left most) cells, or "anchors", of the bricks in each class.  The
+*       key lists the anchors class by class, sorted within each class, one
+*       byte per brick.  Two boards that only differ by swapping bricks of the
+*       same shape get the same key, without renumbering either board.
+*
+*       A move shifts one brick's anchor, so the key can be updated in place by
+*       re-sorting just that brick's class.  Since the shape of each class is
+*       known, a board can also be rebuilt from its key alone (which lets the
+*       external-memory BFS keep nothing but keys).
+*
+*       The dense index of each brick (its key byte) also lets a move be packed
+*       into a single byte, which is how the State Nodes and the Path Store
+*       keep their moves.
+*
+*       The layout of the key is a KEY_LAYOUT, which is part of the Solver
+*       Context of the puzzle (see solver_context.c), so every function here
+*       takes the layout it works with.
+*
+* PUBLIC FUNCTIONS :
+*
+*       void initShapeClasses(KEY_LAYOUT *keys, BOARD *board_state, int board_height, int board_width,
+*                             int max_block_num)
+*       int  getStateKeyWords(KEY_LAYOUT *keys)
+*       int  getStateKeyBytes(KEY_LAYOUT *keys)
+*       void getStateKey(KEY_LAYOUT *keys, BOARD *board_state, STATE_KEY *key)
+*       void keyToBoard(KEY_LAYOUT *keys, STATE_KEY *key, BOARD *board_state)
+*       int  getBrickIndex(KEY_LAYOUT *keys, int block_num)
+*       int  getBrickBlockNum(KEY_LAYOUT *keys, int brick_index)
+*       uint8_t encodeMove(KEY_LAYOUT *keys, MOVE move)
+*       MOVE decodeMove(KEY_LAYOUT *keys, uint8_t move_byte)
+*       void updateStateKey(KEY_LAYOUT *keys, STATE_KEY *key, int block_num, int old_anchor, int new_anchor)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+/* Layout of the canonical key of a puzzle */
+typedef struct KEY_LAYOUT {
+
+    /* Shape class of each block number (0 for walls, goals, and empty cells) */
+    int8_t block_class[MAX_BLOCK_NUM + 1];
+
+    /* First key byte, and number of bricks, of each shape class */
+    int    class_start[MAX_BLOCK_NUM + 2];
+    int    class_count[MAX_BLOCK_NUM + 2];
+    int    num_classes;
+
+    /* Number of bricks (i.e. key bytes), words per key, and cells per board */
+    int    num_bricks;
+    int    num_words;
+    int    num_cells;
+
+    /* For rebuilding boards: the walls and goal cells, the cell offsets of
+       each class's shape, and a block number for each key byte */
+    BOARD  layout;
+    int8_t class_offsets[MAX_BLOCK_NUM + 2][MAX_BOARD_CELLS];
+    int    class_cells[MAX_BLOCK_NUM + 2];
+    int8_t brick_label[MAX_BOARD_CELLS];
+
+    /* Key byte of each block number, i.e. a dense index (0 .. bricks - 1) */
+    int8_t brick_index[MAX_BLOCK_NUM + 1];
+
+} KEY_LAYOUT;
+
+
+/**
+ * Function: getBlockShape
+ *
+ * Fills in the cell offsets (from the first cell) of block # <block_num> on the
+ * <board_state>, and returns the number of cells in the block.
+ */
+
+static int getBlockShape(KEY_LAYOUT *keys, BOARD *board_state, int board_width, int block_num, int *offsets) {
+
+  int i = 0;
+  int first_cell = -1;
+  int num_cells = 0;
+
+  for (i = 0; i < keys->num_cells; i++) {
+    if (board_state->cells[i] == block_num) {
+      if (first_cell < 0) {
+        first_cell = i;
+      }
+
+      /* Offsets are kept as (row, column) pairs, so a shape never wraps */
+      offsets[2 * num_cells]     = i / board_width - first_cell / board_width;
+      offsets[2 * num_cells + 1] = i % board_width - first_cell % board_width;
+      num_cells++;
+    }
+  }
+
+  return num_cells;
+
+}
+
+
+/**
+ * Function: initShapeClasses
+ *
+ * Puts every brick of the puzzle in <board_state> into a shape class, and
+ * lays out the canonical key in <keys>.  Must be called whenever a puzzle is
+ * loaded.
+ */
+
+void initShapeClasses(KEY_LAYOUT *keys, BOARD *board_state, int board_height, int board_width,
+                      int max_block_num) {
+
+  int i,j = 0;
+  int num_cells = 0;
+  int class_num = 0;
+
+  int shape_sizes[MAX_BLOCK_NUM + 1] = {0};
+  int next_byte[MAX_BLOCK_NUM + 2];
+  int shape_offsets[MAX_BLOCK_NUM + 1][2 * MAX_BOARD_CELLS];
+
+  keys->num_cells   = board_height * board_width;
+  keys->num_classes = 1;
+  keys->num_bricks  = 0;
+  memset(keys->block_class, 0, sizeof(keys->block_class));
+  memset(keys->class_count, 0, sizeof(keys->class_count));
+
+  for (i = 2; i <= max_block_num && i <= MAX_BLOCK_NUM; i++) {
+
+    num_cells = getBlockShape(keys, board_state, board_width, i, shape_offsets[i]);
+    shape_sizes[i] = num_cells;
+    if (num_cells == 0) {
+      continue;
+    }
+
+    /* The Master Brick is always a class of its own */
+    class_num = 0;
+    if (i == 2) {
+      class_num = 1;
+    }
+    else
+    {
+      for (j = 3; j < i; j++) {
+        if (shape_sizes[j] == num_cells &&
+            memcmp(shape_offsets[j], shape_offsets[i], sizeof(int) * 2 * num_cells) == 0) {
+          class_num = keys->block_class[j];
+          break;
+        }
+      }
+      if (class_num == 0) {
+        class_num = ++keys->num_classes;
+      }
+    }
+
+    /* The first brick of each class gives the class its shape */
+    if (keys->class_count[class_num] == 0) {
+      keys->class_cells[class_num] = num_cells;
+      for (j = 0; j < num_cells; j++) {
+        keys->class_offsets[class_num][j] = shape_offsets[i][2 * j] * board_width + shape_offsets[i][2 * j + 1];
+      }
+    }
+
+    keys->block_class[i] = class_num;
+    keys->class_count[class_num]++;
+    keys->num_bricks++;
+  }
+
+  /* Each class gets the next run of key bytes */
+  keys->class_start[1] = 0;
+  for (i = 2; i <= keys->num_classes; i++) {
+    keys->class_start[i] = keys->class_start[i - 1] + keys->class_count[i - 1];
+  }
+
+  keys->num_words = (keys->num_bricks + 7) / 8;
+  if (keys->num_words == 0) {
+    keys->num_words = 1;
+  }
+
+  /* Give each key byte one of its class's block numbers */
+  memcpy(next_byte, keys->class_start, sizeof(int) * (keys->num_classes + 1));
+  for (i = 2; i <= max_block_num && i <= MAX_BLOCK_NUM; i++) {
+    if (keys->block_class[i] != 0) {
+      keys->brick_index[i] = next_byte[keys->block_class[i]];
+      keys->brick_label[next_byte[keys->block_class[i]]++] = i;
+    }
+  }
+
+  /* Keep the walls and goal cells */
+  memset(&keys->layout, 0, sizeof(BOARD));
+  for (i = 0; i < keys->num_cells; i++) {
+    if (board_state->cells[i] == 1 || board_state->cells[i] == -1) {
+      keys->layout.cells[i] = board_state->cells[i];
+    }
+  }
+
+}
+
+
+/**
+ * Function: getStateKeyWords
+ *
+ * Returns the number of 64-bit words that are used in each key.
+ */
+
+int getStateKeyWords(KEY_LAYOUT *keys) {
+  return keys->num_words;
+}
+
+
+/**
+ * Function: getStateKeyBytes
+ *
+ * Returns the number of bytes of each key that are used (one per brick).
+ */
+
+int getStateKeyBytes(KEY_LAYOUT *keys) {
+  return keys->num_bricks;
+}
+
+
+/**
+ * Function: getStateKey
+ *
+ * Fills in the canonical <key> of the <board_state>.  Since the cells are
+ * scanned in order, each class's anchors come out already sorted.
+ */
+
+void getStateKey(KEY_LAYOUT *keys, BOARD *board_state, STATE_KEY *key) {
+
+  int i = 0;
+  int block_num = 0;
+  int next_byte[MAX_BLOCK_NUM + 2];
+  bool seen[MAX_BLOCK_NUM + 1] = {false};
+
+  memcpy(next_byte, keys->class_start, sizeof(int) * (keys->num_classes + 1));
+  for (i = 0; i < keys->num_words; i++) {
+    key->words[i] = 0;
+  }
+
+  for (i = 0; i < keys->num_cells; i++) {
+    block_num = board_state->cells[i];
+    if (block_num > 1 && !seen[block_num]) {
+      seen[block_num] = true;
+      key->anchors[next_byte[keys->block_class[block_num]]++] = i;
+    }
+  }
+
+}
+
+
+/**
+ * Function: updateStateKey
+ *
+ * Updates the <key> after block # <block_num> moved its anchor from
+ * <old_anchor> to <new_anchor>, keeping the anchors of its class sorted.
+ */
+
+void updateStateKey(KEY_LAYOUT *keys, STATE_KEY *key, int block_num, int old_anchor, int new_anchor) {
+
+  int class_num = keys->block_class[block_num];
+  int start = keys->class_start[class_num];
+  int end = start + keys->class_count[class_num];
+  int j = start;
+  uint8_t swap = 0;
+
+  while (key->anchors[j] != old_anchor) {
+    j++;
+  }
+  key->anchors[j] = new_anchor;
+
+  while (j + 1 < end && key->anchors[j + 1] < key->anchors[j]) {
+    swap = key->anchors[j];
+    key->anchors[j] = key->anchors[j + 1];
+    key->anchors[++j] = swap;
+  }
+  while (j > start && key->anchors[j - 1] > key->anchors[j]) {
+    swap = key->anchors[j];
+    key->anchors[j] = key->anchors[j - 1];
+    key->anchors[--j] = swap;
+  }
+
+}
+
+
+/**
+ * Function: keyToBoard
+ *
+ * Rebuilds a <board_state> with the canonical <key>.  Bricks of the same shape
+ * get their block numbers in the order of their anchors, so the board may
+ * differ from the one the key was made from, but only by such swaps.
+ */
+
+void keyToBoard(KEY_LAYOUT *keys, STATE_KEY *key, BOARD *board_state) {
+
+  int i,j = 0;
+  int class_num = 0;
+  int anchor = 0;
+
+  *board_state = keys->layout;
+
+  for (i = 0; i < keys->num_bricks; i++) {
+    class_num = keys->block_class[keys->brick_label[i]];
+    anchor = key->anchors[i];
+    for (j = 0; j < keys->class_cells[class_num]; j++) {
+      board_state->cells[anchor + keys->class_offsets[class_num][j]] = keys->brick_label[i];
+    }
+  }
+
+}
+
+
+/**
+ * Function: getBrickIndex
+ *
+ * Returns the dense index (0 .. bricks - 1) of block # <block_num>, which is
+ * small enough to pack into a few bits.
+ */
+
+int getBrickIndex(KEY_LAYOUT *keys, int block_num) {
+  return keys->brick_index[block_num];
+}
+
+
+/**
+ * Function: getBrickBlockNum
+ *
+ * Returns the block number of the brick with the dense index <brick_index>.
+ */
+
+int getBrickBlockNum(KEY_LAYOUT *keys, int brick_index) {
+  return keys->brick_label[brick_index];
+}
+
+
+/**
+ * Function: encodeMove
+ *
+ * Packs a <move> into a single byte: the dense index of the moving brick (at
+ * most 64 bricks fit on a board) in the high 6 bits, and the direction in the
+ * low 2 bits.
+ */
+
+uint8_t encodeMove(KEY_LAYOUT *keys, MOVE move) {
+  return (uint8_t) ((getBrickIndex(keys, move.block_num) << 2) | move.direction);
+}
+
+
+/**
+ * Function: decodeMove
+ *
+ * Unpacks a move that was packed with encodeMove.
+ */
+
+MOVE decodeMove(KEY_LAYOUT *keys, uint8_t move_byte) {
+
+  MOVE move;
+
+  move.block_num = getBrickBlockNum(keys, move_byte >> 2);
+  move.direction = (Move_Direction) (move_byte & 3);
+
+  return move;
+
+}
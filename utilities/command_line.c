@@ -0,0 +1,476 @@
+/************************************************************************
+* FILENAME : command_line.c
+*
+* DESCRIPTION :
+*
+*       Implements the command line interface of the sliding brick puzzle
+*       solver: parsing of the options (puzzle files, search algorithms,
+*       thread count, memory limit, output format, quiet mode, the
+*       benchmarking options, the external-memory BFS's RAM budget and
+*       directory, the A* heuristic and its pattern database directory, and
+*       the batch mode's puzzle list, number of jobs and isolation mode), and
+*       the printing of each search's results in the selected output format.
+*
+* PUBLIC FUNCTIONS :
+*
+*       void printUsage(char *program_name)
+*       bool parseCommandLine(int argc, char **argv, SBP_OPTIONS *options)
+*       bool applyMemoryLimit(SBP_OPTIONS *options)
+*       void printResultsHeader(SBP_OPTIONS *options)
+*       void printSearchResult(SOLVER_CONTEXT *ctx, SBP_OPTIONS *options, SEARCH_RESULT *result)
+*       void printResultsFooter(SBP_OPTIONS *options)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+#include <sys/resource.h>
+
+/* Default puzzle file (used if no puzzle files are given) */
+#define DEFAULT_PUZZLE_FILE "text_files/SBP-level3.txt"
+
+/* Default number of worker threads, and steps of the random walk */
+#define DEFAULT_NUM_THREADS 4
+#define RANDOM_WALK_STEPS   3
+
+/* Implements the Search Algorithm options */
+typedef enum {RANDOM_WALK, BFS, DFS, IDS, ASTAR, IDA_STAR, PARALLEL_BFS, EXTERNAL_BFS,
+              PARALLEL_IDS, PARALLEL_IDA_STAR, HDA_STAR, NUM_ALGORITHMS} Search_Algorithm;
+const char *Algorithm_Strings[] = {"random","bfs","dfs","ids","astar","idastar","pbfs","extbfs",
+                                   "pids","pidastar","hdastar"};
+
+/* Implements the Output Format options */
+typedef enum {TEXT_OUTPUT, CSV_OUTPUT, JSON_OUTPUT} Output_Format;
+const char *Output_Format_Strings[] = {"text","csv","json"};
+
+/* Implements the Heuristic options (of A* and IDA*) */
+typedef enum {MANHATTAN_HEURISTIC, DISTANCE_HEURISTIC, PDB_HEURISTIC} Heuristic_Option;
+const char *Heuristic_Strings[] = {"manhattan","distance","pdb"};
+
+/* Represents the Command Line Options */
+typedef struct SBP_OPTIONS {
+    char        **file_names;                     /* Puzzle files to solve        */
+    int           num_files;                      /* Number of puzzle files       */
+    bool          algorithms[NUM_ALGORITHMS];     /* Selected search algorithms   */
+    int           num_threads;                    /* Threads for parallel search  */
+    long          memory_limit_mb;                /* Address space limit (0=none) */
+    Output_Format output_format;                  /* Format of the result lines   */
+    bool          quiet;                          /* Do not print solution paths  */
+    int           num_repeats;                    /* Runs of each search          */
+    int           scramble_steps;                 /* Steps of scrambled variants  */
+    long          ebfs_memory_mb;                 /* External BFS RAM budget      */
+    char         *ebfs_directory;                 /* External BFS file directory  */
+    Heuristic_Option heuristic;                   /* h(n) of A* and IDA*          */
+    char         *pdb_directory;                  /* Pattern database directory   */
+    char         *puzzle_list;                    /* Manifest or directory        */
+    int           num_jobs;                       /* Puzzles solved at once       */
+    bool          isolate_jobs;                   /* One process per puzzle       */
+} SBP_OPTIONS;
+
+/* Represents the Result of one run of a search */
+typedef struct SEARCH_RESULT {
+    char            *puzzle;           /* Puzzle file (and scramble)     */
+    Search_Algorithm algorithm;        /* Search algorithm               */
+    int              num_threads;      /* Threads used by the search     */
+    int              run;              /* Run number (1 .. num_repeats)  */
+    int              path_cost;        /* Path cost found, or -1         */
+    int              closed_set_size;  /* States in the closed set       */
+    long             nodes_expanded;   /* States whose moves were made   */
+    long             nodes_generated;  /* Successor states created       */
+    double           wall_seconds;     /* Elapsed wall-clock time        */
+    double           cpu_seconds;      /* Elapsed CPU time (all threads) */
+    long             peak_memory_kb;   /* Peak memory (or -1 if unknown) */
+} SEARCH_RESULT;
+
+/* Default puzzle file list */
+static char *default_file_names[] = {DEFAULT_PUZZLE_FILE};
+
+/* Number of results printed to stdout so far (for separating JSON objects) */
+static int num_results_printed = 0;
+
+
+/**
+ * Function: printUsage
+ *
+ * Prints the command line usage to the screen.
+ */
+
+void printUsage(char *program_name) {
+
+  printf("Usage: %s [options] [puzzle_file ...]\n", program_name);
+  printf("\n");
+  printf("Solves each puzzle file (default: %s) with each selected algorithm.\n", DEFAULT_PUZZLE_FILE);
+  printf("\n");
+  printf("Options:\n");
+  printf("  -a ALGORITHMS  comma separated list of: random, bfs, dfs, ids, astar, idastar, pbfs, extbfs,\n");
+  printf("                 pids, pidastar, hdastar, all\n");
+  printf("                 (default: all)\n");
+  printf("  -t N           number of threads for the parallel searches (default: %d)\n", DEFAULT_NUM_THREADS);
+  printf("  -m MB          limit the memory (address space) of the process to MB megabytes\n");
+  printf("  -f FORMAT      output format of the results: text, csv, json (default: text)\n");
+  printf("  -q             quiet: do not print the solution paths\n");
+  printf("  -r N           run each search N times (default: 1)\n");
+  printf("  -g STEPS       also solve a variant of each puzzle, scrambled by STEPS random moves\n");
+  printf("  -b MB          RAM budget of the external-memory BFS (default: %d)\n", EBFS_DEFAULT_MEMORY_MB);
+  printf("  -d DIR         directory for the external-memory BFS's files (default: %s)\n", EBFS_DEFAULT_DIRECTORY);
+  printf("  -H HEURISTIC   heuristic of astar, idastar, pidastar, hdastar: manhattan, distance, pdb (default: distance)\n");
+  printf("  -p DIR         directory to save and load the pattern databases in (default: none)\n");
+  printf("  -l LIST        also solve every puzzle in LIST: a directory (its .txt files), or a\n");
+  printf("                 manifest file (one puzzle file per line)\n");
+  printf("  -j N           solve up to N puzzles at the same time, in separate threads (default: 1)\n");
+  printf("  -i             isolate the puzzles of -j: solve each one in a process of its own\n");
+  printf("  -h             print this help message\n");
+
+}
+
+
+/**
+ * Function: parseAlgorithms
+ *
+ * Parses a comma separated list of algorithm names into <options>.  Returns
+ * false if one of the names is not a known algorithm.
+ */
+
+static bool parseAlgorithms(char *algorithm_list, SBP_OPTIONS *options) {
+
+  int   i = 0;
+  bool  found = false;
+  char *name = strtok(algorithm_list, ",");
+
+  for (i = 0; i < NUM_ALGORITHMS; i++) {
+    options->algorithms[i] = false;
+  }
+
+  while (name != NULL) {
+
+    found = false;
+    for (i = 0; i < NUM_ALGORITHMS; i++) {
+      if (strcmp(name, Algorithm_Strings[i]) == 0 || strcmp(name, "all") == 0) {
+        options->algorithms[i] = true;
+        found = true;
+      }
+    }
+
+    if (!found) {
+      fprintf(stderr, "Unknown algorithm: %s\n", name);
+      return false;
+    }
+
+    name = strtok(NULL, ",");
+  }
+
+  return true;
+
+}
+
+
+/**
+ * Function: parseCommandLine
+ *
+ * Parses the command line arguments into <options>.  Returns false if the
+ * program should exit (bad arguments, or help was requested).
+ */
+
+bool parseCommandLine(int argc, char **argv, SBP_OPTIONS *options) {
+
+  int  i = 0;
+  int  option = 0;
+  bool format_found = false;
+  bool heuristic_found = false;
+
+  /* Default Options */
+  options->file_names      = default_file_names;
+  options->num_files       = 1;
+  options->num_threads     = DEFAULT_NUM_THREADS;
+  options->memory_limit_mb = 0;
+  options->output_format   = TEXT_OUTPUT;
+  options->quiet           = false;
+  options->num_repeats     = 1;
+  options->scramble_steps  = 0;
+  options->ebfs_memory_mb  = EBFS_DEFAULT_MEMORY_MB;
+  options->ebfs_directory  = EBFS_DEFAULT_DIRECTORY;
+  options->heuristic       = DISTANCE_HEURISTIC;
+  options->pdb_directory   = NULL;
+  options->puzzle_list     = NULL;
+  options->num_jobs        = 1;
+  options->isolate_jobs    = false;
+  for (i = 0; i < NUM_ALGORITHMS; i++) {
+    options->algorithms[i] = true;
+  }
+
+  while ((option = getopt(argc, argv, "a:t:m:f:qr:g:b:d:H:p:l:j:ih")) != -1) {
+    switch (option) {
+
+      case 'a':
+        if (!parseAlgorithms(optarg, options)) {
+          return false;
+        }
+        break;
+
+      case 't':
+        options->num_threads = (int) strtol(optarg, NULL, 10);
+        if (options->num_threads < 1) {
+          fprintf(stderr, "Number of threads must be at least 1.\n");
+          return false;
+        }
+        break;
+
+      case 'm':
+        options->memory_limit_mb = strtol(optarg, NULL, 10);
+        break;
+
+      case 'f':
+        format_found = false;
+        for (i = 0; i <= JSON_OUTPUT; i++) {
+          if (strcmp(optarg, Output_Format_Strings[i]) == 0) {
+            options->output_format = (Output_Format) i;
+            format_found = true;
+          }
+        }
+        if (!format_found) {
+          fprintf(stderr, "Unknown output format: %s\n", optarg);
+          return false;
+        }
+        break;
+
+      case 'q':
+        options->quiet = true;
+        break;
+
+      case 'r':
+        options->num_repeats = (int) strtol(optarg, NULL, 10);
+        if (options->num_repeats < 1) {
+          fprintf(stderr, "Number of runs must be at least 1.\n");
+          return false;
+        }
+        break;
+
+      case 'g':
+        options->scramble_steps = (int) strtol(optarg, NULL, 10);
+        break;
+
+      case 'b':
+        options->ebfs_memory_mb = strtol(optarg, NULL, 10);
+        if (options->ebfs_memory_mb < 1) {
+          fprintf(stderr, "RAM budget must be at least 1 MB.\n");
+          return false;
+        }
+        break;
+
+      case 'd':
+        options->ebfs_directory = optarg;
+        break;
+
+      case 'H':
+        heuristic_found = false;
+        for (i = 0; i <= PDB_HEURISTIC; i++) {
+          if (strcmp(optarg, Heuristic_Strings[i]) == 0) {
+            options->heuristic = (Heuristic_Option) i;
+            heuristic_found = true;
+          }
+        }
+        if (!heuristic_found) {
+          fprintf(stderr, "Unknown heuristic: %s\n", optarg);
+          return false;
+        }
+        break;
+
+      case 'p':
+        options->pdb_directory = optarg;
+        break;
+
+      case 'l':
+        options->puzzle_list = optarg;
+        break;
+
+      case 'j':
+        options->num_jobs = (int) strtol(optarg, NULL, 10);
+        if (options->num_jobs < 1) {
+          fprintf(stderr, "Number of jobs must be at least 1.\n");
+          return false;
+        }
+        break;
+
+      case 'i':
+        options->isolate_jobs = true;
+        break;
+
+      default:
+        printUsage(argv[0]);
+        return false;
+
+    }
+  }
+
+  /* Remaining arguments are the Puzzle Files */
+  if (optind < argc) {
+    options->file_names = &argv[optind];
+    options->num_files  = argc - optind;
+  }
+
+  /* Solution paths would break up the CSV and JSON output */
+  if (options->output_format != TEXT_OUTPUT) {
+    options->quiet = true;
+  }
+
+  return true;
+
+}
+
+
+/**
+ * Function: applyMemoryLimit
+ *
+ * Limits the address space of the process to the memory limit in <options>
+ * (if one was given).  Returns false if the limit could not be set.
+ */
+
+bool applyMemoryLimit(SBP_OPTIONS *options) {
+
+  struct rlimit limit;
+
+  if (options->memory_limit_mb <= 0) {
+    return true;
+  }
+
+  limit.rlim_cur = (rlim_t) options->memory_limit_mb * 1024 * 1024;
+  limit.rlim_max = limit.rlim_cur;
+
+  if (setrlimit(RLIMIT_AS, &limit) != 0) {
+    fprintf(stderr, "Could not set the memory limit to %ld MB.\n", options->memory_limit_mb);
+    return false;
+  }
+
+  return true;
+
+}
+
+
+/**
+ * Function: printJsonString
+ *
+ * Prints the <string> to the <output> as a JSON string (in quotes, with
+ * quotes, backslashes and control characters escaped).
+ */
+
+static void printJsonString(FILE *output, const char *string) {
+
+  const unsigned char *c = (const unsigned char *) string;
+
+  fputc('"', output);
+  for (; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') {
+      fprintf(output, "\\%c", *c);
+    }
+    else if (*c < 0x20)
+    {
+      fprintf(output, "\\u%04x", *c);
+    }
+    else
+    {
+      fputc(*c, output);
+    }
+  }
+  fputc('"', output);
+
+}
+
+
+/**
+ * Function: printResultsHeader
+ *
+ * Prints whatever comes before the first result in the selected output format.
+ */
+
+void printResultsHeader(SBP_OPTIONS *options) {
+
+  num_results_printed = 0;
+
+  if (options->output_format == CSV_OUTPUT) {
+    printf("puzzle,algorithm,threads,run,path_cost,closed_set,nodes_expanded,nodes_generated,"
+           "wall_seconds,cpu_seconds,peak_memory_kb,states_per_second\n");
+  }
+  else if (options->output_format == JSON_OUTPUT) {
+    printf("[\n");
+  }
+
+}
+
+
+/**
+ * Function: printSearchResult
+ *
+ * Prints the <result> of one run of a search to the output of the <ctx>, in
+ * the selected output format.
+ * The text format is the same one as always: the number of states in the closed
+ * set, the run time, and the path cost, i.e. "<nodes> (<N> seconds and <M>/1000)
+ * <path_cost>".  CSV and JSON output include every measurement in the <result>,
+ * plus the number of states generated per (wall-clock) second.  A peak memory
+ * that is not known is left empty in CSV, and is null in JSON.
+ */
+
+void printSearchResult(SOLVER_CONTEXT *ctx, SBP_OPTIONS *options, SEARCH_RESULT *result) {
+
+  double states_per_second = 0.0;
+  char   peak_memory[24] = {0};
+
+  if (result->wall_seconds > 0.0) {
+    states_per_second = (double) result->nodes_generated / result->wall_seconds;
+  }
+
+  switch (options->output_format) {
+
+    case CSV_OUTPUT:
+      /* An unknown peak memory is left empty */
+      if (result->peak_memory_kb >= 0) {
+        snprintf(peak_memory, sizeof(peak_memory), "%ld", result->peak_memory_kb);
+      }
+      fprintf(ctx->output, "%s,%s,%d,%d,%d,%d,%ld,%ld,%.6f,%.6f,%s,%.0f\n",
+              result->puzzle, Algorithm_Strings[result->algorithm], result->num_threads, result->run,
+              result->path_cost, result->closed_set_size, result->nodes_expanded, result->nodes_generated,
+              result->wall_seconds, result->cpu_seconds, peak_memory, states_per_second);
+      break;
+
+    case JSON_OUTPUT:
+      /* An unknown peak memory is null */
+      snprintf(peak_memory, sizeof(peak_memory), (result->peak_memory_kb >= 0) ? "%ld" : "null",
+               result->peak_memory_kb);
+      fprintf(ctx->output, "%s  {\"puzzle\": ", (ctx->num_results_printed > 0) ? ",\n" : "");
+      printJsonString(ctx->output, result->puzzle);
+      fprintf(ctx->output, ", \"algorithm\": \"%s\", \"threads\": %d, \"run\": %d, "
+              "\"path_cost\": %d, \"closed_set\": %d, \"nodes_expanded\": %ld, \"nodes_generated\": %ld, "
+              "\"wall_seconds\": %.6f, \"cpu_seconds\": %.6f, \"peak_memory_kb\": %s, "
+              "\"states_per_second\": %.0f}",
+              Algorithm_Strings[result->algorithm], result->num_threads, result->run,
+              result->path_cost, result->closed_set_size, result->nodes_expanded, result->nodes_generated,
+              result->wall_seconds, result->cpu_seconds, peak_memory, states_per_second);
+      break;
+
+    default:
+      fprintf(ctx->output, "%d ", result->closed_set_size);
+      printElapsedRunTime(ctx->output, result->cpu_seconds);
+      fprintf(ctx->output, " %d\n\n", result->path_cost);
+      break;
+
+  }
+
+  ctx->num_results_printed++;
+  fflush(ctx->output);
+
+}
+
+
+/**
+ * Function: printResultsFooter
+ *
+ * Prints whatever comes after the last result in the selected output format.
+ */
+
+void printResultsFooter(SBP_OPTIONS *options) {
+
+  if (options->output_format == JSON_OUTPUT) {
+    printf("%s]\n", (num_results_printed > 0) ? "\n" : "");
+  }
+
+}
@@ -4,14 +4,17 @@
 * DESCRIPTION :
 *
 *       Implements a First-in-Last-Out (FILO) stack for use in the DFS algorith
-*       Note that the nodes in the queue contain information about their board_state
-*       parent board_state, and move from the parent to the current board state.
+*       Note that the nodes in the stack contain their board_state, path cost, and
+*       the index of the state in the search's Path Store (which is how the path
+*       to the state is found).  The nodes are allocated from the search's arena,
+*       and the DFS gives each one back to the arena once it is expanded.
 *
 * PUBLIC FUNCTIONS :
 *
-*       void dfsPushStack(int **board_state, MOVE *input_move, STATE_NODE *parent)
-*       STATE_NODE* dfsPopStack()
-*       bool dfsStackIsEmpty()
+*       void dfsPushStack(DFS_STACK *stack, ARENA *arena, BOARD *board_state, int path_cost, int path_index)
+*       STATE_NODE* dfsPopStack(DFS_STACK *stack)
+*       bool dfsStackIsEmpty(DFS_STACK *stack)
+*       void drainStack(DFS_STACK *stack)
 *
 * AUTHOR : Philip Cheng
 * DATE   : 18 October 2017
@@ -19,43 +22,40 @@
 ************************************************************************/
 
 
-/* Head of the DFS FILO Stack (i.e. no tail is necessary since this is FILO) */
-STATE_NODE *dfs_filo_head = NULL;
+/* DFS FILO Stack: its Head (i.e. no tail is necessary since this is FILO) */
+typedef struct DFS_STACK {
+    STATE_NODE *head;
+} DFS_STACK;
 
 
 /**
  * Function: dfsPushStack
  *
- * Creates a State Node with the given information (board_state, move, and
- * parent) and pushes the Node onto the FILO Stack, at the HEAD end.
+ * Creates a State Node (in the <arena>) with a copy of the given information
+ * (board_state, path cost, and Path Store index) and pushes the Node onto the
+ * FILO <stack>, at the HEAD end.
  */
 
-void dfsPushStack(int **board_state, MOVE *input_move, STATE_NODE *parent) {
+void dfsPushStack(DFS_STACK *stack, ARENA *arena, BOARD *board_state, int path_cost, int path_index) {
 
   /* Create the new State Node */
-  STATE_NODE *new_node = malloc(sizeof(STATE_NODE));
-  new_node->board_state = board_state;
-  new_node->move_from_parent = input_move;
-  new_node->parent = parent;
+  STATE_NODE *new_node = arenaAllocNode(arena);
+  new_node->board_state = *board_state;
+  new_node->move_from_parent = 0;
+  new_node->parent = NULL;
+  new_node->path_index = path_index;
+  new_node->path_cost = path_cost;
+  new_node->heuristic = 0;
   new_node->next = NULL;
 
-  /* Update Path Cost (for Depth Limited Search) */
-  if (parent != NULL) {
-    new_node->path_cost = parent->path_cost + 1;
-  }
-  else
-  {
-    new_node->path_cost = 0;
-  }
-
   /* Push new State Node to Stack (i.e. Update Head) */
-  if (dfs_filo_head == NULL){
-    dfs_filo_head = new_node;
+  if (stack->head == NULL){
+    stack->head = new_node;
   }
   else
   {
-    new_node->next = dfs_filo_head;
-    dfs_filo_head = new_node;
+    new_node->next = stack->head;
+    stack->head = new_node;
   }
 
 }
@@ -64,14 +64,14 @@ void dfsPushStack(int **board_state, MOVE *input_move, STATE_NODE *parent) {
 /**
  * Function: dfsPopStack
  *
- * Pops and returns a pointer to the State Node at the HEAD of the FILO Stack.
+ * Pops and returns a pointer to the State Node at the HEAD of the FILO <stack>.
  */
 
-STATE_NODE* dfsPopStack() {
+STATE_NODE* dfsPopStack(DFS_STACK *stack) {
 
-  STATE_NODE *return_node = dfs_filo_head;
-  STATE_NODE *new_head = dfs_filo_head->next;
-  dfs_filo_head = new_head;
+  STATE_NODE *return_node = stack->head;
+  STATE_NODE *new_head = stack->head->next;
+  stack->head = new_head;
   return return_node;
 
 }
@@ -80,9 +80,21 @@ STATE_NODE* dfsPopStack() {
 /**
  * Function: dfsStackIsEmpty
  *
- * Returns true is the FILO Stack is empty
+ * Returns true is the FILO <stack> is empty
+ */
+
+bool dfsStackIsEmpty(DFS_STACK *stack) {
+  return (stack->head == NULL);
+}
+
+
+/**
+ * Function: drainStack
+ *
+ * Provides a way to empty out the FILO <stack> (the State Nodes themselves are
+ * released along with the search's arena).
  */
 
-bool dfsStackIsEmpty() {
-  return (dfs_filo_head == NULL);
+void drainStack(DFS_STACK *stack) {
+  stack->head = NULL;
 }
@@ -0,0 +1,240 @@
+/************************************************************************
+* FILENAME : master_distance_map.c
+*
+* DESCRIPTION :
+*
+*       Implements the master brick's distance map, which is computed once
+*       when a puzzle is loaded, and gives the A* and IDA* Searches an h(n)
+*       that is looked up rather than calculated.
+*
+*       The map is a BFS over the positions of the master brick (by its first
+*       cell, or "anchor") on the empty board, i.e. with only the walls in its
+*       way (the master brick may cover the goal cells).  It gives the exact
+*       number of moves from each anchor to the nearest goal position, which
+*       is never more than the real number of moves of the master brick.
+*
+*       For each anchor, the map also keeps the cells that the master brick
+*       cannot get to the goal without covering (found by taking each cell off
+*       the board in turn, and checking if the goal can still be reached).
+*       Every other brick on one of these cells has to move at least once, so
+*       the number of such bricks is added on top of the distance (each of
+*       their moves is a move the master brick does not make).
+*
+*       The map is a MASTER_DISTANCE_MAP, which is part of the Solver Context
+*       of the puzzle (see solver_context.c).
+*
+* PUBLIC FUNCTIONS :
+*
+*       void initMasterDistanceMap(MASTER_DISTANCE_MAP *map, BOARD *board_state, int board_height,
+*                                  int board_width)
+*       int  getMasterDistanceHeuristic(MASTER_DISTANCE_MAP *map, KEY_LAYOUT *keys, BOARD *board_state)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+/* Distance of anchors where the master brick cannot reach the goal */
+#define MASTER_UNREACHABLE 255
+
+/* Set to false to use the Manhattan distance instead (see get_heuristic) */
+bool use_distance_map = true;
+
+/* Master Brick's Distance Map of a puzzle */
+typedef struct MASTER_DISTANCE_MAP {
+
+    /* Board size, and the cells covered by the master brick at each anchor (0
+       if the master brick does not fit there) */
+    int      width;
+    int      height;
+    uint64_t footprint[MAX_BOARD_CELLS];
+
+    /* Distance to the goal, and the cells that must be covered on the way
+       there, from each anchor */
+    uint8_t  distance[MAX_BOARD_CELLS];
+    uint64_t required_cells[MAX_BOARD_CELLS];
+
+} MASTER_DISTANCE_MAP;
+
+
+/**
+ * Function: masterMapBFS
+ *
+ * Runs a BFS over the anchors of the <map>, from the anchors in <sources>,
+ * that skips every anchor whose footprint covers a cell in <blocked_cells>.
+ * If <distances> is not NULL, the distance of each anchor is filled in.
+ * Returns the anchors that were reached (as a bitmask).
+ */
+
+static uint64_t masterMapBFS(MASTER_DISTANCE_MAP *map, uint64_t sources, uint64_t blocked_cells,
+                             uint8_t *distances) {
+
+  int i,k = 0;
+  int row,col = 0;
+  int anchor = 0;
+  int next_anchor = 0;
+  int head = 0;
+  int tail = 0;
+  int queue[MAX_BOARD_CELLS];
+  uint64_t reached = 0;
+
+  for (i = 0; i < map->height * map->width; i++) {
+    if ((sources >> i) & 1 && (map->footprint[i] & blocked_cells) == 0) {
+      reached |= (uint64_t) 1 << i;
+      queue[tail++] = i;
+      if (distances != NULL) {
+        distances[i] = 0;
+      }
+    }
+  }
+
+  while (head < tail) {
+    anchor = queue[head++];
+    for (k = UP; k <= RIGHT; k++) {
+      row = anchor / map->width + Move_Row_Deltas[k];
+      col = anchor % map->width + Move_Col_Deltas[k];
+      if (row < 0 || row >= map->height || col < 0 || col >= map->width) {
+        continue;
+      }
+      next_anchor = row * map->width + col;
+      if (map->footprint[next_anchor] == 0 || (map->footprint[next_anchor] & blocked_cells) != 0 ||
+          (reached >> next_anchor) & 1) {
+        continue;
+      }
+      reached |= (uint64_t) 1 << next_anchor;
+      queue[tail++] = next_anchor;
+      if (distances != NULL) {
+        distances[next_anchor] = distances[anchor] + 1;
+      }
+    }
+  }
+
+  return reached;
+
+}
+
+
+/**
+ * Function: initMasterDistanceMap
+ *
+ * Computes the master brick's distance <map> for the puzzle in <board_state>,
+ * with the given <board_height> and <board_width>.  Must be called whenever
+ * a puzzle is loaded.
+ */
+
+void initMasterDistanceMap(MASTER_DISTANCE_MAP *map, BOARD *board_state, int board_height, int board_width) {
+
+  int i,j,c = 0;
+  int num_cells = 0;
+  int first_cell = -1;
+  int row,col = 0;
+  int offsets[2 * MAX_BOARD_CELLS];
+  uint64_t walls = 0;
+  uint64_t goals = 0;
+  uint64_t goal_anchors = 0;
+  uint64_t footprint = 0;
+
+  map->width  = board_width;
+  map->height = board_height;
+  memset(map->distance, MASTER_UNREACHABLE, sizeof(map->distance));
+  memset(map->required_cells, 0, sizeof(map->required_cells));
+
+  /* Shape of the Master Brick, and the Walls and Goal Cells */
+  for (i = 0; i < board_height * board_width; i++) {
+    if (board_state->cells[i] == 2) {
+      if (first_cell < 0) {
+        first_cell = i;
+      }
+      offsets[2 * num_cells]     = i / board_width - first_cell / board_width;
+      offsets[2 * num_cells + 1] = i % board_width - first_cell % board_width;
+      num_cells++;
+    }
+    else if (board_state->cells[i] == 1)
+    {
+      walls |= (uint64_t) 1 << i;
+    }
+    else if (board_state->cells[i] == -1)
+    {
+      goals |= (uint64_t) 1 << i;
+    }
+  }
+
+  /* Footprint of the Master Brick at each anchor (and the goal anchors) */
+  for (i = 0; i < board_height * board_width; i++) {
+    footprint = 0;
+    for (j = 0; j < num_cells; j++) {
+      row = i / board_width + offsets[2 * j];
+      col = i % board_width + offsets[2 * j + 1];
+      if (row < 0 || row >= board_height || col < 0 || col >= board_width ||
+          (walls >> (row * board_width + col)) & 1) {
+        footprint = 0;
+        break;
+      }
+      footprint |= (uint64_t) 1 << (row * board_width + col);
+    }
+    map->footprint[i] = footprint;
+    if (footprint != 0 && (footprint & goals) == goals) {
+      goal_anchors |= (uint64_t) 1 << i;
+    }
+  }
+
+  /* Distances (moves are reversible, so the BFS starts at the goal) */
+  masterMapBFS(map, goal_anchors, 0, map->distance);
+
+  /* Cells that the Master Brick has to cover on its way to the goal */
+  for (i = 0; i < board_height * board_width; i++) {
+    if (map->distance[i] == MASTER_UNREACHABLE) {
+      continue;
+    }
+    for (c = 0; c < board_height * board_width; c++) {
+      if ((walls >> c) & 1 || (map->footprint[i] >> c) & 1) {
+        continue;
+      }
+      if ((masterMapBFS(map, (uint64_t) 1 << i, (uint64_t) 1 << c, NULL) & goal_anchors) == 0) {
+        map->required_cells[i] |= (uint64_t) 1 << c;
+      }
+    }
+  }
+
+}
+
+
+/**
+ * Function: getMasterDistanceHeuristic
+ *
+ * Returns the distance <map>'s h(n) of the <board_state>: the master brick's
+ * distance to the goal, plus one for each other brick that is in its way (the
+ * bricks are told apart by their index in the key layout <keys>).
+ */
+
+int getMasterDistanceHeuristic(MASTER_DISTANCE_MAP *map, KEY_LAYOUT *keys, BOARD *board_state) {
+
+  int i = 0;
+  int anchor = 0;
+  int block_num = 0;
+  int num_blocking = 0;
+  uint64_t required = 0;
+  uint64_t counted = 0;
+
+  while (anchor < map->height * map->width && board_state->cells[anchor] != 2) {
+    anchor++;
+  }
+  if (anchor == map->height * map->width) {
+    return 0;
+  }
+
+  /* Count each brick on the required cells once */
+  required = map->required_cells[anchor];
+  while (required != 0) {
+    i = __builtin_ctzll(required);
+    required &= required - 1;
+    block_num = board_state->cells[i];
+    if (block_num > 2 && !((counted >> getBrickIndex(keys, block_num)) & 1)) {
+      counted |= (uint64_t) 1 << getBrickIndex(keys, block_num);
+      num_blocking++;
+    }
+  }
+
+  return map->distance[anchor] + num_blocking;
+
+}
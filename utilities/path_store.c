@@ -0,0 +1,104 @@
+/************************************************************************
+* FILENAME : path_store.c
+*
+* DESCRIPTION :
+*
+*       Implements a compact store of the paths found by a search, so that the
+*       State Nodes themselves do not have to be kept around just to print the
+*       solution.  Every state that a search adds to its frontier gets the next
+*       index in the store, and the store keeps only two things per state, in
+*       two dense arrays indexed by insertion order: the index of its parent
+*       (-1 for the start state), and the move from the parent, packed into a
+*       single byte (see encodeMove).  That is 5 bytes per state.
+*
+*       The solution is rebuilt by following the parent indexes back to the
+*       start state, and replaying the moves from the start board (see
+*       printStoredSolution in printer.c).
+*
+* PUBLIC FUNCTIONS :
+*
+*       int  pathStoreReset(PATH_STORE *store)
+*       void pathStoreFree(PATH_STORE *store)
+*       int pathStoreAdd(PATH_STORE *store, int parent_index, uint8_t move_byte)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+/* Initial number of states in a Path Store (grows as needed) */
+#define PATH_STORE_INITIAL_SIZE 4096
+
+/* Path Store: parent index and packed move of every state, by insertion order */
+typedef struct PATH_STORE {
+    int32_t *parents;
+    uint8_t *moves;
+    int      count;
+    int      capacity;
+} PATH_STORE;
+
+/* Index of the start state in every Path Store */
+#define PATH_STORE_ROOT 0
+
+
+/**
+ * Function: pathStoreFree
+ *
+ * Cleans up the memory used by the <store>.
+ */
+
+void pathStoreFree(PATH_STORE *store) {
+
+  free(store->parents);
+  free(store->moves);
+
+  store->parents  = NULL;
+  store->moves    = NULL;
+  store->count    = 0;
+  store->capacity = 0;
+
+}
+
+
+/**
+ * Function: pathStoreAdd
+ *
+ * Adds a state, reached from the state with <parent_index> (-1 for the start
+ * state) by the move packed in <move_byte> (see encodeMove), to the <store>.
+ * Returns the index of the new state.
+ */
+
+int pathStoreAdd(PATH_STORE *store, int parent_index, uint8_t move_byte) {
+
+  /* Grow the arrays (if they are full) */
+  if (store->count == store->capacity) {
+    store->capacity = (store->capacity > 0) ? store->capacity * 2 : PATH_STORE_INITIAL_SIZE;
+    store->parents  = realloc(store->parents, sizeof(int32_t) * store->capacity);
+    store->moves    = realloc(store->moves, sizeof(uint8_t) * store->capacity);
+    if (store->parents == NULL || store->moves == NULL) {
+      fprintf(stderr, "Out of memory (path store).\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  store->parents[store->count] = parent_index;
+  store->moves[store->count]   = move_byte;
+
+  return store->count++;
+
+}
+
+
+/**
+ * Function: pathStoreReset
+ *
+ * Empties the <store> (keeping its memory for the next search), and adds the
+ * start state to it.  Returns the start state's index, i.e. PATH_STORE_ROOT.
+ */
+
+int pathStoreReset(PATH_STORE *store) {
+
+  store->count = 0;
+  return pathStoreAdd(store, -1, 0);
+
+}
@@ -4,12 +4,17 @@
 * DESCRIPTION :
 *
 *       Contains utility functions for printing moves and search paths
-*       to the screen.
+*       to the output of a Solver Context (the screen, unless the batch
+*       solver collects a puzzle's output).  The searches never renumber the blocks, so the moves
+*       of a path are printed with the block numbers of the normalized
+*       states they are made from.
 *
 * PUBLIC FUNCTIONS :
 *
-*       void printMove(MOVE* move)
-*       void printPath(STATE_NODE *input_node)
+*       void printMove(SOLVER_CONTEXT *ctx, MOVE* move)
+*       void printPath(SOLVER_CONTEXT *ctx, STATE_NODE *input_node)
+*       void printSolution(SOLVER_CONTEXT *ctx, STATE_NODE *parent_node, MOVE *final_move, BOARD *goal_state)
+*       void printStoredSolution(SOLVER_CONTEXT *ctx, BOARD *start_state, int parent_index, MOVE final_move)
 *
 * AUTHOR : Philip Cheng
 * DATE   : 18 October 2017
@@ -17,16 +22,46 @@
 ************************************************************************/
 
 
+/* Set to false to keep the searches from printing their solutions (quiet mode) */
+bool print_solution = true;
+
+
 /**
  * Function: printMove
  *
- * Prints the contents of the Move to the screen, including the Block number
- * and the direction that the block is moving.
+ * Prints the contents of the Move to the output of the <ctx>, including the
+ * Block number and the direction that the block is moving.
+ */
+
+void printMove(SOLVER_CONTEXT *ctx, MOVE* move) {
+
+  fprintf(ctx->output, "(%d,%s)\n",move->block_num, Move_Strings[move->direction]);
+
+}
+
+
+/**
+ * Function: printNormalizedMove
+ *
+ * Prints the <move> made from the <board_state>, with the block's number in
+ * the normalized <board_state>.
  */
 
-void printMove(MOVE* move) {
+static void printNormalizedMove(SOLVER_CONTEXT *ctx, BOARD *board_state, MOVE *move) {
+
+  int  i = 0;
+  BOARD normalized_state = *board_state;
+  MOVE  normalized_move  = *move;
 
-  printf("(%d,%s)\n",move->block_num, Move_Strings[move->direction]);
+  normalizeState(ctx, &normalized_state);
+  for (i = 0; i < MAX_BOARD_CELLS; i++) {
+    if (board_state->cells[i] == move->block_num) {
+      normalized_move.block_num = normalized_state.cells[i];
+      break;
+    }
+  }
+
+  printMove(ctx, &normalized_move);
 
 }
 
@@ -35,18 +70,111 @@ void printMove(MOVE* move) {
  * Function: printPath
  *
  * Traverses the State Node Graph and recursively prints out each move from the
- * boards original state all the way down to the current <input_state>.
+ * boards original state all the way down to the current <input_state> (of the
+ * puzzle in <ctx>).
  */
 
-void printPath(STATE_NODE *input_node) {
+void printPath(SOLVER_CONTEXT *ctx, STATE_NODE *input_node) {
+
+  MOVE move_from_parent;
 
   if (input_node == NULL || input_node->parent == NULL) {
     return;
   }
   else
   {
-    printPath(input_node->parent);
-    printMove(input_node->move_from_parent);
+    printPath(ctx, input_node->parent);
+    move_from_parent = decodeMove(&ctx->keys, input_node->move_from_parent);
+    printNormalizedMove(ctx, &input_node->parent->board_state, &move_from_parent);
   }
 
 }
+
+
+/**
+ * Function: printSolution
+ *
+ * Prints the path to the goal state found by a search (i.e. the path to the
+ * goal's <parent_node>, followed by the <final_move>), and prints the goal
+ * state itself.  Nothing is printed in quiet mode.
+ */
+
+void printSolution(SOLVER_CONTEXT *ctx, STATE_NODE *parent_node, MOVE *final_move, BOARD *goal_state) {
+
+  BOARD normalized_goal = *goal_state;
+
+  if (!print_solution) {
+    return;
+  }
+
+  normalizeState(ctx, &normalized_goal);
+  printPath(ctx, parent_node);
+  printNormalizedMove(ctx, &parent_node->board_state, final_move);
+  printState(ctx, &normalized_goal);
+
+}
+
+
+/**
+ * Function: printStoredSolution
+ *
+ * Prints the path to the goal state found by a search, i.e. the path from the
+ * <start_state> to the state with <parent_index> in the Path Store of the
+ * <ctx>, followed by the <final_move>, and prints the goal state.  The path is
+ * replayed on a chain of State Nodes (allocated from the search's arena), so
+ * that it is printed just like every other search's solution.
+ */
+
+void printStoredSolution(SOLVER_CONTEXT *ctx, BOARD *start_state, int parent_index, MOVE final_move) {
+
+  int   i,j = 0;
+  int   path_cost = 0;
+  uint8_t *path_moves = NULL;
+  BOARD goal_state;
+  PATH_STORE *store = &ctx->paths;
+  STATE_NODE *path_node = NULL;
+  STATE_NODE *new_node  = NULL;
+
+  if (!print_solution) {
+    return;
+  }
+
+  /* Follow the parent indexes back to the start state */
+  for (i = parent_index; store->parents[i] >= 0; i = store->parents[i]) {
+    path_cost++;
+  }
+  path_moves = arenaAlloc(&ctx->arena, sizeof(uint8_t) * (path_cost + 1));
+  j = path_cost;
+  for (i = parent_index; store->parents[i] >= 0; i = store->parents[i]) {
+    path_moves[--j] = store->moves[i];
+  }
+
+  /* Root State Node */
+  path_node = arenaAlloc(&ctx->arena, sizeof(STATE_NODE));
+  path_node->board_state = *start_state;
+  path_node->move_from_parent = 0;
+  path_node->parent = NULL;
+  path_node->path_index = -1;
+  path_node->next = NULL;
+  path_node->path_cost = 0;
+  path_node->heuristic = 0;
+
+  /* Replay the moves */
+  for (j = 0; j < path_cost; j++) {
+    new_node = arenaAlloc(&ctx->arena, sizeof(STATE_NODE));
+    new_node->board_state = path_node->board_state;
+    applyMove(ctx, &new_node->board_state, decodeMove(&ctx->keys, path_moves[j]));
+    new_node->move_from_parent = path_moves[j];
+    new_node->parent = path_node;
+    new_node->path_index = -1;
+    new_node->next = NULL;
+    new_node->path_cost = j + 1;
+    new_node->heuristic = 0;
+    path_node = new_node;
+  }
+
+  goal_state = path_node->board_state;
+  applyMove(ctx, &goal_state, final_move);
+  printSolution(ctx, path_node, &final_move, &goal_state);
+
+}
@@ -4,14 +4,17 @@
 * DESCRIPTION :
 *
 *       Implements a timer for use in measuring execution time for the various
-*       search algorithms, and a method for printing the elapsed time.
+*       search algorithms, and a method for printing the elapsed time.  The timer
+*       measures both the CPU time of the process (summed over all threads) and
+*       the wall-clock time.
 *
 * PUBLIC FUNCTIONS :
 *
-*      void startRunTimer()
-*      void endRunTimer()
-*      double getElapsedRunTime()
-*      void printElapsedRunTime()
+*      void startRunTimer(RUN_TIMER *timer)
+*      void endRunTimer(RUN_TIMER *timer)
+*      double getElapsedRunTime(RUN_TIMER *timer)
+*      double getElapsedWallTime(RUN_TIMER *timer)
+*      void printElapsedRunTime(FILE *output, double run_time)
 *
 * AUTHOR : Philip Cheng
 * DATE   : 18 October 2017
@@ -20,52 +23,71 @@
 
 #include <time.h>
 
-static clock_t start_time = 0;
-static clock_t end_time   = 0;
+/* Run Timer: the CPU and wall-clock times at its start and end */
+typedef struct RUN_TIMER {
+    clock_t         start_time;
+    clock_t         end_time;
+    struct timespec start_wall_time;
+    struct timespec end_wall_time;
+} RUN_TIMER;
 
 
 /**
  * Function: startRunTimer
  *
- * Starts the Run Timer, given the current system clock time.
+ * Starts the Run <timer>, given the current system clock time.
  */
 
-void startRunTimer() {
-  start_time = clock();
+void startRunTimer(RUN_TIMER *timer) {
+  timer->start_time = clock();
+  clock_gettime(CLOCK_MONOTONIC, &timer->start_wall_time);
 }
 
 
 /**
  * Function: endRunTimer
  *
- * Ends the Run Timer, given the current system clock time.
+ * Ends the Run <timer>, given the current system clock time.
  */
 
-void endRunTimer() {
-  end_time = clock();
+void endRunTimer(RUN_TIMER *timer) {
+  timer->end_time = clock();
+  clock_gettime(CLOCK_MONOTONIC, &timer->end_wall_time);
 }
 
 
 /**
  * Function: getElapsedRunTime
  *
- * Calculates and returns the elapsed time (in seconds).
+ * Calculates and returns the elapsed CPU time (in seconds) of the <timer>.
  */
 
-double getElapsedRunTime() {
-  return (double) (end_time - start_time) / CLOCKS_PER_SEC;
+double getElapsedRunTime(RUN_TIMER *timer) {
+  return (double) (timer->end_time - timer->start_time) / CLOCKS_PER_SEC;
+}
+
+
+/**
+ * Function: getElapsedWallTime
+ *
+ * Calculates and returns the elapsed wall-clock time (in seconds) of the <timer>.
+ */
+
+double getElapsedWallTime(RUN_TIMER *timer) {
+  return (double) (timer->end_wall_time.tv_sec - timer->start_wall_time.tv_sec) +
+         (double) (timer->end_wall_time.tv_nsec - timer->start_wall_time.tv_nsec) / 1e9;
 }
 
 
 /**
  * Function: printElapsedRunTime
  *
- * Prints the elapsed time to the screen in the format of seconds and fractions
- * of a second (e.g. 2.534 --> "2 seconds and 534/1000").
+ * Prints an elapsed <run_time> to the <output> in the format of seconds and
+ * fractions of a second (e.g. 2.534 --> "2 seconds and 534/1000").
  */
 
-void printElapsedRunTime() {
-  int seconds = (int) getElapsedRunTime();
-  int milliseconds = (int) ((getElapsedRunTime() - (double) seconds) * 1000);
-  printf("(%d seconds and %d/1000)", seconds, milliseconds);
+void printElapsedRunTime(FILE *output, double run_time) {
+  int seconds = (int) run_time;
+  int milliseconds = (int) ((run_time - (double) seconds) * 1000);
+  fprintf(output, "(%d seconds and %d/1000)", seconds, milliseconds);
 }
@@ -0,0 +1,194 @@
+/************************************************************************
+* FILENAME : search_arena.c
+*
+* DESCRIPTION :
+*
+*       Implements a search-scoped arena (bump-pointer) allocator.  All of the
+*       memory that a search needs for as long as it runs (State Nodes, and the
+*       lists of moves that they point to) is carved out of large blocks, and is
+*       released all at once with a single reset at the end of the search.  The
+*       blocks are kept around for the next search, so running many searches
+*       back to back does not keep growing memory.
+*
+*       State Nodes that a search is done with (e.g. once they are expanded) can
+*       be given back to the arena, which hands them out again before carving
+*       new ones out of its blocks, so a search only needs room for its
+*       frontier.
+*
+* PUBLIC FUNCTIONS :
+*
+*       void *arenaAlloc(ARENA *arena, size_t size)
+*       void arenaReset(ARENA *arena)
+*       void arenaRelease(ARENA *arena)
+*       STATE_NODE *arenaAllocNode(ARENA *arena)
+*       void arenaFreeNode(ARENA *arena, STATE_NODE *node)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+/* Size of each Arena Block, and alignment of every allocation */
+#define ARENA_BLOCK_SIZE (1 << 20)
+#define ARENA_ALIGNMENT  16
+
+/* Block of memory owned by an Arena */
+typedef struct ARENA_BLOCK {
+    struct ARENA_BLOCK *next;  /* Next block (in use, or free)  */
+    size_t size;               /* Usable bytes in this block    */
+    size_t used;               /* Bytes handed out so far       */
+    char  *data;               /* Start of the usable bytes     */
+} ARENA_BLOCK;
+
+/* Arena: the list of blocks in use, and the list of free blocks */
+typedef struct ARENA {
+    ARENA_BLOCK *blocks;
+    ARENA_BLOCK *free_blocks;
+    STATE_NODE  *free_nodes;   /* State Nodes given back (to reuse) */
+} ARENA;
+
+
+/**
+ * Function: arenaAlloc
+ *
+ * Returns a pointer to <size> bytes from the <arena>.  This is just a pointer
+ * bump, unless the current block is full, in which case a block is taken from
+ * the free list (or a new block is allocated).
+ */
+
+void *arenaAlloc(ARENA *arena, size_t size) {
+
+  void        *return_ptr = NULL;
+  ARENA_BLOCK *block      = arena->blocks;
+  ARENA_BLOCK *prev_block = NULL;
+  size_t       block_size = ARENA_BLOCK_SIZE;
+
+  /* Round the size up to keep every allocation aligned */
+  size = (size + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+
+  /* Get a new block (if the current block does not have enough room) */
+  if (block == NULL || block->used + size > block->size) {
+
+    /* Look for a big enough block in the free list */
+    block = arena->free_blocks;
+    while (block != NULL && block->size < size) {
+      prev_block = block;
+      block = block->next;
+    }
+
+    if (block != NULL) {
+      if (prev_block == NULL) {
+        arena->free_blocks = block->next;
+      }
+      else
+      {
+        prev_block->next = block->next;
+      }
+    }
+    else
+    {
+      if (size > block_size) {
+        block_size = size;
+      }
+      block = malloc(sizeof(ARENA_BLOCK) + ARENA_ALIGNMENT + block_size);
+      if (block == NULL) {
+        fprintf(stderr, "Out of memory (search arena).\n");
+        exit(EXIT_FAILURE);
+      }
+      block->size = block_size;
+      block->data = (char *) (((uintptr_t) (block + 1) + ARENA_ALIGNMENT - 1) & ~((uintptr_t) ARENA_ALIGNMENT - 1));
+    }
+
+    block->used  = 0;
+    block->next  = arena->blocks;
+    arena->blocks = block;
+  }
+
+  /* Bump the pointer */
+  return_ptr = block->data + block->used;
+  block->used += size;
+
+  return return_ptr;
+
+}
+
+
+/**
+ * Function: arenaReset
+ *
+ * Releases everything allocated from the <arena> at once.  The blocks are moved
+ * to the free list, so that the next search can reuse them.
+ */
+
+void arenaReset(ARENA *arena) {
+
+  ARENA_BLOCK *block = arena->blocks;
+  ARENA_BLOCK *next_block = NULL;
+
+  while (block != NULL) {
+    next_block = block->next;
+    block->next = arena->free_blocks;
+    arena->free_blocks = block;
+    block = next_block;
+  }
+
+  arena->blocks = NULL;
+  arena->free_nodes = NULL;
+
+}
+
+
+/**
+ * Function: arenaRelease
+ *
+ * Resets the <arena> and gives all of its blocks back to the system.
+ */
+
+void arenaRelease(ARENA *arena) {
+
+  ARENA_BLOCK *block = NULL;
+
+  arenaReset(arena);
+
+  while (arena->free_blocks != NULL) {
+    block = arena->free_blocks;
+    arena->free_blocks = block->next;
+    free(block);
+  }
+
+}
+
+
+/**
+ * Function: arenaAllocNode
+ *
+ * Returns a State Node from the <arena>, reusing one that was given back (see
+ * arenaFreeNode) if there is one.
+ */
+
+STATE_NODE *arenaAllocNode(ARENA *arena) {
+
+  STATE_NODE *node = arena->free_nodes;
+
+  if (node != NULL) {
+    arena->free_nodes = node->next;
+    return node;
+  }
+
+  return arenaAlloc(arena, sizeof(STATE_NODE));
+
+}
+
+
+/**
+ * Function: arenaFreeNode
+ *
+ * Gives a State <node> back to the <arena>, once the search is done with it.
+ */
+
+void arenaFreeNode(ARENA *arena, STATE_NODE *node) {
+
+  node->next = arena->free_nodes;
+  arena->free_nodes = node;
+
+}
@@ -0,0 +1,142 @@
+/************************************************************************
+* FILENAME : search_goal.c
+*
+* DESCRIPTION :
+*
+*       Implements the Search Goal, which the worker threads of a parallel
+*       search use to tell each other about the solutions they find.  It keeps
+*       the lowest path cost found so far (and which worker found it), and a
+*       flag that is raised once that cost is known to be optimal, at which
+*       point every worker stops as soon as it next checks the flag.
+*
+*       When a solution is confirmed depends on the search: in a level-
+*       synchronous BFS, any solution found while expanding a layer is
+*       optimal; in a best-first search, a solution is only confirmed once no
+*       open node has a lower f(n) (so its goal test is delayed until then),
+*       and until that point the best cost is used to prune.
+*
+*       The Search Goal does not keep the solution path itself: each worker
+*       keeps the path of the best solution it found, and once the workers
+*       have stopped, the path is taken from the worker that found the best.
+*       So only a solution's cost (not its path) goes through the lock.
+*
+* PUBLIC FUNCTIONS :
+*
+*       void initSearchGoal(SEARCH_GOAL *goal)
+*       bool offerSearchGoal(SEARCH_GOAL *goal, int path_cost, int worker)
+*       void confirmSearchGoal(SEARCH_GOAL *goal)
+*       bool searchGoalConfirmed(SEARCH_GOAL *goal)
+*       int  getSearchGoalCost(SEARCH_GOAL *goal)
+*       void freeSearchGoal(SEARCH_GOAL *goal)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+#include <limits.h>
+#include <pthread.h>
+
+/* Path cost of a Search Goal before any solution is found */
+#define SEARCH_GOAL_NONE INT_MAX
+
+/* Best solution found by the workers of a search */
+typedef struct SEARCH_GOAL {
+    pthread_mutex_t lock;
+    int             path_cost;  /* Lowest path cost found (SEARCH_GOAL_NONE if none) */
+    int             worker;     /* Worker that found it (-1 if none)                 */
+    bool            confirmed;  /* Set once the path cost is known to be optimal     */
+} SEARCH_GOAL;
+
+
+/**
+ * Function: initSearchGoal
+ *
+ * Sets up an empty Search <goal> (no solution found yet).
+ */
+
+void initSearchGoal(SEARCH_GOAL *goal) {
+
+  pthread_mutex_init(&goal->lock, NULL);
+  goal->path_cost = SEARCH_GOAL_NONE;
+  goal->worker    = -1;
+  goal->confirmed = false;
+
+}
+
+
+/**
+ * Function: offerSearchGoal
+ *
+ * Offers a solution with the given <path_cost>, found by worker # <worker>, to
+ * the Search <goal>.  Returns true if it is the best solution so far, in which
+ * case the worker must keep its path (until the search is over).
+ */
+
+bool offerSearchGoal(SEARCH_GOAL *goal, int path_cost, int worker) {
+
+  bool is_best = false;
+
+  /* Cheap check first, as most late solutions are no better */
+  if (path_cost >= __atomic_load_n(&goal->path_cost, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+
+  pthread_mutex_lock(&goal->lock);
+  if (path_cost < goal->path_cost) {
+    goal->worker = worker;
+    __atomic_store_n(&goal->path_cost, path_cost, __ATOMIC_RELEASE);
+    is_best = true;
+  }
+  pthread_mutex_unlock(&goal->lock);
+
+  return is_best;
+
+}
+
+
+/**
+ * Function: confirmSearchGoal
+ *
+ * Marks the best solution of the Search <goal> as optimal, which tells every
+ * worker to stop.
+ */
+
+void confirmSearchGoal(SEARCH_GOAL *goal) {
+  __atomic_store_n(&goal->confirmed, true, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * Function: searchGoalConfirmed
+ *
+ * Returns true once the Search <goal> is confirmed (i.e. the workers should
+ * stop).  Cheap enough to check for every node.
+ */
+
+static inline bool searchGoalConfirmed(SEARCH_GOAL *goal) {
+  return __atomic_load_n(&goal->confirmed, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * Function: getSearchGoalCost
+ *
+ * Returns the lowest path cost found so far (SEARCH_GOAL_NONE if none), e.g.
+ * to prune nodes whose f(n) cannot beat it.
+ */
+
+static inline int getSearchGoalCost(SEARCH_GOAL *goal) {
+  return __atomic_load_n(&goal->path_cost, __ATOMIC_ACQUIRE);
+}
+
+
+/**
+ * Function: freeSearchGoal
+ *
+ * Cleans up the Search <goal> (once every worker has stopped).
+ */
+
+void freeSearchGoal(SEARCH_GOAL *goal) {
+  pthread_mutex_destroy(&goal->lock);
+}
@@ -0,0 +1,84 @@
+/************************************************************************
+* FILENAME : search_stats.c
+*
+* DESCRIPTION :
+*
+*       Implements the counters used for measuring the work done by the various
+*       search algorithms (nodes expanded and nodes generated, and the size of
+*       the closed set), and a way to measure the peak memory used by a search.
+*       Each Solver Context has its own counters.
+*
+*       The peak resident memory of a process can only go up, so when it is
+*       reported (CSV and JSON output), each search is run in a process forked
+*       for it (see runSearch), which starts out at the memory it was forked
+*       with.  The search's peak memory is how far the peak went up from
+*       there, whatever earlier searches, or the other puzzles of a batch,
+*       have used.
+*
+* PUBLIC FUNCTIONS :
+*
+*       void resetSearchStats(SEARCH_STATS *stats)
+*       void countExpandedNode(SEARCH_STATS *stats, int num_generated)
+*       long getPeakMemoryKB()
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+#include <sys/resource.h>
+
+/* Counters of the work done by a search */
+typedef struct SEARCH_STATS {
+    long nodes_expanded;   /* States whose moves were generated */
+    long nodes_generated;  /* Successor states created          */
+    int  closed_set_size;  /* States kept in the closed set     */
+} SEARCH_STATS;
+
+
+/**
+ * Function: resetSearchStats
+ *
+ * Resets the counters in <stats>, to get ready for a new search.
+ */
+
+void resetSearchStats(SEARCH_STATS *stats) {
+  stats->nodes_expanded  = 0;
+  stats->nodes_generated = 0;
+  stats->closed_set_size = 0;
+}
+
+
+/**
+ * Function: countExpandedNode
+ *
+ * Counts one expanded node in <stats>, which generated <num_generated>
+ * successor states.
+ */
+
+void countExpandedNode(SEARCH_STATS *stats, int num_generated) {
+  stats->nodes_expanded++;
+  stats->nodes_generated += num_generated;
+}
+
+
+/**
+ * Function: getPeakMemoryKB
+ *
+ * Returns the peak resident memory of the process so far (in kilobytes), or
+ * -1 if it is not known.  In a process forked for one search, the difference
+ * between the values at the start and at the end of the search is the peak
+ * memory of that search alone.
+ */
+
+long getPeakMemoryKB() {
+
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return -1;
+  }
+
+  return usage.ru_maxrss;
+
+}
@@ -0,0 +1,127 @@
+/************************************************************************
+* FILENAME : solver_context.c
+*
+* DESCRIPTION :
+*
+*       Implements the Solver Context, which holds everything about one loaded
+*       puzzle (its board size, start state, walls and goal cells, canonical
+*       key layout, and heuristic tables) and about the search running on it
+*       (its closed set, open lists, arena, path store, and counters), and
+*       where its output goes.  The game and search functions take the
+*       context they work on explicitly, rather than sharing globals, so that
+*       independent searches can run at the same time in one process, each
+*       with a context of its own.
+*
+*       The game functions (getAllAvailableMoves, makeMove, checkGameComplete,
+*       and so on) only read the puzzle part of a context, so the threads of a
+*       parallel search can share a context, as long as each thread keeps its
+*       own search state (e.g. its own arena and counters).
+*
+* PUBLIC FUNCTIONS :
+*
+*       void initSolverContext(SOLVER_CONTEXT *ctx)
+*       void releaseSearchMemory(SOLVER_CONTEXT *ctx)
+*       void freeSolverContext(SOLVER_CONTEXT *ctx)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+/* Solver Context (declared in definitions.h) */
+struct SOLVER_CONTEXT {
+
+    /* Puzzle: board size, highest block, the start state (NULL if no puzzle
+       is loaded), and the walls and goal cells only (no bricks) */
+    int    board_width;
+    int    board_height;
+    int    max_block_num;
+    BOARD *board_state;
+    BOARD  board_layout;
+
+    /* Goal cells of the puzzle (recorded when it is loaded) */
+    int    num_goal_cells;
+    int    goal_cells[MAX_BOARD_CELLS];
+
+    /* Board Kernels for the puzzle's board size (see board_kernels.c) */
+    const struct BOARD_KERNELS *kernels;
+
+    /* Tables made when the puzzle is loaded, and its Pattern Database (made
+       by the first search that uses it, and kept for the next searches) */
+    KEY_LAYOUT               keys;
+    MASTER_DISTANCE_MAP      distance_map;
+    struct PATTERN_DATABASE *pdb;
+
+    /* Output: where the solutions and results are printed (stdout, unless
+       the batch solver collects them), and the number of results printed
+       there so far (for separating JSON objects) */
+    FILE  *output;
+    int    num_results_printed;
+
+    /* Search: closed set, open lists, memory, solution paths, and counters */
+    STATE_HASH_TABLE closed_set;
+    BFS_QUEUE        bfs_queue;
+    DFS_STACK        dfs_stack;
+    ASTAR_OPEN_LIST  open_list;
+    ARENA            arena;
+    PATH_STORE       paths;
+    SEARCH_STATS     stats;
+
+};
+
+
+/**
+ * Function: initSolverContext
+ *
+ * Sets up an empty Solver Context <ctx> (with no puzzle loaded).
+ */
+
+void initSolverContext(SOLVER_CONTEXT *ctx) {
+
+  memset(ctx, 0, sizeof(SOLVER_CONTEXT));
+  ctx->board_state = NULL;
+  ctx->pdb = NULL;
+  ctx->output = stdout;
+
+  initZobristKeys();
+  initBoardSimd();
+
+}
+
+
+/**
+ * Function: releaseSearchMemory
+ *
+ * Gives the memory used by the last search of the <ctx> (its closed set, open
+ * lists, arena, and path store) back to the system, so that the peak memory
+ * of the next search is measured on its own.
+ */
+
+void releaseSearchMemory(SOLVER_CONTEXT *ctx) {
+
+  hashTableFree(&ctx->closed_set);
+  drainQueue(&ctx->bfs_queue);
+  drainStack(&ctx->dfs_stack);
+  astarClearOpenList(&ctx->open_list);
+  arenaRelease(&ctx->arena);
+  pathStoreFree(&ctx->paths);
+
+}
+
+
+/**
+ * Function: freeSolverContext
+ *
+ * Cleans up all of the memory used by the <ctx>, including its puzzle and its
+ * Pattern Database.
+ */
+
+void freeSolverContext(SOLVER_CONTEXT *ctx) {
+
+  releaseSearchMemory(ctx);
+  freePatternDatabase(ctx);
+
+  free(ctx->board_state);
+  ctx->board_state = NULL;
+
+}
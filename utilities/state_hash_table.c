@@ -8,233 +8,412 @@
 *       loops are not re-searched.  In the DEPTH-first search, a Hash Table Node
 *       may actually be searched again IFF a new path to the node's state is
 *       found with a lower path cost.  Therefore, the Key-Value pairs for this
-*       hash table are a string encoding of the game's board_state as the key,
-*       and the path-cost to get to that board_state from the starting state as
-*       the value.
+*       hash table are the board_state's canonical key (see canonical_key.c) as
+*       the key, and the path-cost to get to that board_state from the starting
+*       state as the value.
+*
+*       The hash table uses open addressing (linear probing) over a flat array
+*       of slots, with the key stored inline in each slot.  Only the words of
+*       the key that the current puzzle uses are stored, so the size of a slot
+*       depends on the number of bricks.  Keys are hashed with 64-bit Zobrist
+*       hashing, i.e. the XOR of one random number per (cell, shape class) pair
+*       for the cells covered by bricks.  Like the key, the hash does not change
+*       when bricks of the same shape are swapped, and it can be updated
+*       incrementally when only a few cells change.  The table doubles in size
+*       whenever its load factor would exceed STATE_HASH_TABLE_MAX_LOAD.
+*
+*       The table itself is a STATE_HASH_TABLE, so that every search can have
+*       its own: the BFS, DFS, and A* Searches use the closed set in their
+*       Solver Context (see solver_context.c), and searches which need more than
+*       one closed set (e.g. one shard per lock in the parallel BFS) create
+*       their own.  The Key-Value functions take the key's Zobrist hash along
+*       with the key, since the searches keep it up to date incrementally (see
+*       makeMove).  The Zobrist random numbers are the same for every puzzle,
+*       so they are filled in once, and only read after that.
 *
 * PUBLIC FUNCTIONS :
 *
-*       void initStateHashTable(int board_height, int board_width, int max_block_num)
-*       void resetHashTable()
-*       char *getStateHashKey(int **input_state)
-*       int getHashKeyIndex(char *hashkey)
-*       void insertIntoStateHashTable(char *key, int value)
-*       int getHashTableValue(char *key)
-*       void updateHashTableValue(char *key, int value)
+*       void initZobristKeys()
+*       void initStateHashTable(STATE_HASH_TABLE *table, int key_words)
+*       uint64_t getStateHashKey(KEY_LAYOUT *keys, BOARD *input_state)
+*       uint64_t updateStateHashKey(KEY_LAYOUT *keys, uint64_t hashkey, int cell, int old_block, int new_block)
+*       void insertIntoStateHashTable(STATE_HASH_TABLE *table, STATE_KEY *key, uint64_t hashkey, int value)
+*       int getHashTableValue(STATE_HASH_TABLE *table, STATE_KEY *key, uint64_t hashkey)
+*       void updateHashTableValue(STATE_HASH_TABLE *table, STATE_KEY *key, uint64_t hashkey, int value)
+*       void hashTableInit(STATE_HASH_TABLE *table, int key_words)
+*       void hashTableFree(STATE_HASH_TABLE *table)
+*       int hashTableGet(STATE_HASH_TABLE *table, STATE_KEY *key, uint64_t hashkey)
+*       int hashTableInsertIfAbsent(STATE_HASH_TABLE *table, STATE_KEY *key, uint64_t hashkey, int value)
 *
 * AUTHOR : Philip Cheng
 * DATE   : 18 October 2017
 *
 ************************************************************************/
 
-#define STATE_HASH_TABLE_SIZE 1000
+#include <pthread.h>
 
-/* Nodes in Hash Table */
-typedef struct HASH_TABLE_NODE {
-    char  *key;
-    int    value;
-    struct HASH_TABLE_NODE *next;
-} HASH_TABLE_NODE;
+/* Initial number of slots (must be a power of 2) and max load factor (%) */
+#define STATE_HASH_TABLE_INITIAL_SIZE 1024
+#define STATE_HASH_TABLE_MAX_LOAD     50
 
-/* State Parameters (used for Hash functions) */
-static int state_hashtable_board_height  = 0;
-static int state_hashtable_board_width   = 0;
-static int state_hashtable_max_block_num = 0;
+/* Seed for generating the Zobrist random numbers */
+#define ZOBRIST_SEED 0x9E3779B97F4A7C15ULL
 
-/* Number of Nodes in the Hash Table */
-static int hash_table_node_count = 0;
+/* Slots in Hash Table (an empty slot has a negative value), followed by the
+   words of the key */
+typedef struct HASH_TABLE_SLOT {
+    uint64_t hash;
+    int      value;
+    uint64_t key[];
+} HASH_TABLE_SLOT;
 
-/* Hash Table Implementation */
-HASH_TABLE_NODE *state_hashtable[STATE_HASH_TABLE_SIZE] = {NULL};
+/* Zobrist random numbers, indexed by [cell][shape class] (class 0, i.e. no
+   brick, is all zeros) */
+static uint64_t       zobrist_keys[MAX_BOARD_CELLS][MAX_BLOCK_NUM + 2];
+static pthread_once_t zobrist_keys_once = PTHREAD_ONCE_INIT;
+
+/* Hash Table: a power-of-2 array of slots, and the number of slots in use */
+typedef struct STATE_HASH_TABLE {
+    char     *slots;
+    uint64_t  size;
+    int       count;
+    int       key_words;  /* Words of each key that are stored */
+    size_t    slot_size;  /* Bytes per slot, including the key */
+} STATE_HASH_TABLE;
 
 
 /**
- * Function: initStateHashTable
+ * Function: hashTableSlot
  *
- * Sets up the hash table's parameters and sets each slot in the table to NULL.
+ * Returns slot # <index> of the <table>.
  */
 
-void initStateHashTable(int board_height, int board_width, int max_block_num) {
+static inline HASH_TABLE_SLOT *hashTableSlot(STATE_HASH_TABLE *table, uint64_t index) {
+  return (HASH_TABLE_SLOT *) (table->slots + index * table->slot_size);
+}
 
-  int i = 0;
 
-  state_hashtable_board_height  = board_height;
-  state_hashtable_board_width   = board_width;
-  state_hashtable_max_block_num = max_block_num;
+/**
+ * Function: fillZobristKeys
+ *
+ * Fills in the Zobrist random numbers, using a fixed-seed splitmix64 generator
+ * so that hash values are reproducible from run to run.
+ */
+
+static void fillZobristKeys() {
 
-  hash_table_node_count = 0;
+  int i,j = 0;
+  uint64_t seed = ZOBRIST_SEED;
+  uint64_t z = 0;
 
-  for (i = 0; i < STATE_HASH_TABLE_SIZE; i++) {
-    state_hashtable[i] = NULL;
+  for (i = 0; i < MAX_BOARD_CELLS; i++) {
+    for (j = 0; j < MAX_BLOCK_NUM + 2; j++) {
+      seed += 0x9E3779B97F4A7C15ULL;
+      z = seed;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      zobrist_keys[i][j] = z ^ (z >> 31);
+    }
+    zobrist_keys[i][0] = 0;
   }
 
 }
 
 
 /**
- * Function: initStateHashTable
+ * Function: initZobristKeys
  *
- * Clears the hash table, cleans up memory, and resets each slot in the table
- * back to NULL.  This is usefule for preparing the Hash Table for a brand new
- * search, or a new level of Iterative Deepening Search (IDS).
+ * Fills in the Zobrist random numbers, the first time it is called (from any
+ * thread).  Must be called before any state is hashed.
  */
 
-void resetHashTable() {
+void initZobristKeys() {
+  pthread_once(&zobrist_keys_once, fillZobristKeys);
+}
 
-  int i = 0;
-  HASH_TABLE_NODE *current_node = NULL;
-  HASH_TABLE_NODE *next_node = NULL;
-
-  /* Reset Number of Nodes in Hash Table back to Zero */
-  hash_table_node_count = 0;
-
-  /* Clean Up Memory */
-  for (i = 0; i < STATE_HASH_TABLE_SIZE; i++) {
-    current_node = state_hashtable[i];
-    while (current_node != NULL) {
-      next_node = current_node->next;
-      free(current_node->key);
-      free(current_node);
-      current_node = next_node;
-    }
+
+/**
+ * Function: allocateHashTableSlots
+ *
+ * Allocates <table->size> empty slots for the <table>.
+ */
+
+static void allocateHashTableSlots(STATE_HASH_TABLE *table) {
+
+  uint64_t i = 0;
+
+  table->slots = malloc(table->slot_size * table->size);
+  if (table->slots == NULL) {
+    fprintf(stderr, "Out of memory (state hash table).\n");
+    exit(EXIT_FAILURE);
   }
+
+  for (i = 0; i < table->size; i++) {
+    hashTableSlot(table, i)->value = -1;
+  }
+
 }
 
 
 /**
- * Function: getStateHashKey
+ * Function: hashTableInit
  *
- * Creates a simple UNIQUE Hash Key (string) given an <input_state> board_state.
- * Accomplishes this by encoding each block value on a predetermined board size
- * to a letter (i.e. 0 --> 'A', 1 --> 'B', 2 --> 'C', etc. )
+ * Allocates an empty <table> with STATE_HASH_TABLE_INITIAL_SIZE slots, sized
+ * for keys of <key_words> words (see getStateKeyWords).
  */
 
-char *getStateHashKey(int **input_state) {
+void hashTableInit(STATE_HASH_TABLE *table, int key_words) {
 
-  int  i,j   = 0;
-  int  index = 0;
+  table->size      = STATE_HASH_TABLE_INITIAL_SIZE;
+  table->count     = 0;
+  table->key_words = key_words;
+  table->slot_size = sizeof(HASH_TABLE_SLOT) + sizeof(uint64_t) * table->key_words;
+  allocateHashTableSlots(table);
 
-  char *hashkey = malloc(sizeof(char) * ((state_hashtable_board_height - 2) * (state_hashtable_board_width - 2) + 1));
+}
 
-  for (i = 1; i < state_hashtable_board_height - 1; i++) {
-    for (j = 1; j < state_hashtable_board_width - 1; j++) {
-      hashkey[index++] = (char) input_state[i][j] + 'A';
-    }
-  }
 
-  hashkey[index] = '\0';
-  return hashkey;
+/**
+ * Function: hashTableFree
+ *
+ * Cleans up the memory used by the <table>.
+ */
+
+void hashTableFree(STATE_HASH_TABLE *table) {
+
+  free(table->slots);
+
+  table->slots = NULL;
+  table->size  = 0;
+  table->count = 0;
+
+}
+
+
+/**
+ * Function: initStateHashTable
+ *
+ * Clears the <table>, cleans up its memory, and resets it back to an empty
+ * table of its initial size (for keys of <key_words> words).  This is useful
+ * for preparing a closed set for a brand new search.
+ */
+
+void initStateHashTable(STATE_HASH_TABLE *table, int key_words) {
+
+  hashTableFree(table);
+  hashTableInit(table, key_words);
+
+}
+
+
+/**
+ * Function: cellClass
+ *
+ * Returns the shape class (in the key layout <keys>) of the <block> in a cell
+ * (0 if it is not a brick).
+ */
 
+static inline int cellClass(KEY_LAYOUT *keys, int block) {
+  return (block > 1) ? keys->block_class[block] : 0;
 }
 
 
 /**
- * Function: getHashKeyIndex
+ * Function: getStateHashKey
  *
- * Calculates the unique Hash Key's index within the Hashtable, as a weighted
- * sum of the Hash Key's char values -- all modulo the size of the Hash Table.
+ * Calculates the 64-bit Zobrist Hash Key of an <input_state> board_state, i.e.
+ * the XOR of the Zobrist random numbers of every (cell, shape class) pair,
+ * with the shape classes of the key layout <keys>.  Only the cells covered by
+ * bricks are visited, since the other cells hash to 0.
  */
 
-int getHashKeyIndex(char *hashkey) {
+uint64_t getStateHashKey(KEY_LAYOUT *keys, BOARD *input_state) {
 
   int i = 0;
-  int running_total = 0;
-  int key_len = strlen(hashkey);
+  uint64_t hashkey = 0;
+  uint64_t brick_cells = boardCellsAbove(input_state, 1) & boardCellsMask(keys->num_cells);
 
-  for (i = 0; i < key_len; i++) {
-    running_total += hashkey[i] * (i+1);
+  while (brick_cells != 0) {
+    i = __builtin_ctzll(brick_cells);
+    brick_cells &= brick_cells - 1;
+    hashkey ^= zobrist_keys[i][keys->block_class[input_state->cells[i]]];
   }
 
-  return running_total % STATE_HASH_TABLE_SIZE;
+  return hashkey;
 
 }
 
 
 /**
- * Function: insertIntoStateHashTable
+ * Function: updateStateHashKey
  *
- * Inserts a Key-Value pair into the Hash Table
+ * Incrementally updates a Zobrist <hashkey> when the contents of a single
+ * <cell> change from <old_block> to <new_block>.
  */
 
-void insertIntoStateHashTable(char *key, int value) {
+uint64_t updateStateHashKey(KEY_LAYOUT *keys, uint64_t hashkey, int cell, int old_block, int new_block) {
+  return hashkey ^ zobrist_keys[cell][cellClass(keys, old_block)] ^ zobrist_keys[cell][cellClass(keys, new_block)];
+}
 
-  /* Get Hash Table Index */
-  int index = getHashKeyIndex(key);
-  HASH_TABLE_NODE *location = state_hashtable[index];
 
-  /* Create New State Node */
-  HASH_TABLE_NODE *new_state = malloc(sizeof(HASH_TABLE_NODE));
+/**
+ * Function: findHashTableSlot
+ *
+ * Probes the <table> (linearly) for the given <key> with the given <hashkey>.
+ * Returns the slot holding the key, or the empty slot where it would go.
+ */
 
-  /* Fill in New State Data */
-  new_state->key   = key;
-  new_state->value = value;
-  new_state->next  = NULL;
+static HASH_TABLE_SLOT *findHashTableSlot(STATE_HASH_TABLE *table, uint64_t *key, uint64_t hashkey) {
+
+  int i = 0;
+  uint64_t mask  = table->size - 1;
+  uint64_t index = hashkey & mask;
+  HASH_TABLE_SLOT *slot = NULL;
+
+  while (true) {
 
-  /* Insert New State Node into Hash Table */
-  if (location == NULL) {
-    state_hashtable[index] = new_state;
+    slot = hashTableSlot(table, index);
+
+    /* Empty slot: the key is not in the table */
+    if (slot->value < 0) {
+      return slot;
+    }
+
+    /* Compare full keys only when the hashes match */
+    if (slot->hash == hashkey) {
+      for (i = 0; i < table->key_words; i++) {
+        if (slot->key[i] != key[i]) {
+          break;
+        }
+      }
+      if (i == table->key_words) {
+        return slot;
+      }
+    }
+
+    index = (index + 1) & mask;
   }
-  else
-  {
-    while (location->next != NULL) {
-      location = location->next;
+
+}
+
+
+/**
+ * Function: growStateHashTable
+ *
+ * Doubles the size of the <table>, and re-inserts all of its Key-Value pairs.
+ */
+
+static void growStateHashTable(STATE_HASH_TABLE *table) {
+
+  uint64_t i = 0;
+  STATE_HASH_TABLE old_table = *table;
+  HASH_TABLE_SLOT *old_slot = NULL;
+  HASH_TABLE_SLOT *slot = NULL;
+
+  table->size = old_table.size * 2;
+  allocateHashTableSlots(table);
+
+  for (i = 0; i < old_table.size; i++) {
+    old_slot = hashTableSlot(&old_table, i);
+    if (old_slot->value >= 0) {
+      slot = findHashTableSlot(table, old_slot->key, old_slot->hash);
+      memcpy(slot, old_slot, table->slot_size);
     }
-    location->next = new_state;
   }
 
-  /* Update counter */
-  hash_table_node_count++;
+  free(old_table.slots);
 
 }
 
 
 /**
- * Function: getHashTableValue
+ * Function: hashTableGet
  *
- * Returns a Value, given a Key.  Since the values that are stored are path-costs,
- * all of the values must be non-negative.  Therefore, if the key is not found, this
- * function will return -1, to indicate that the Key-Value pair is not in the table.
+ * Returns the Value stored in the <table> for the <key> (with Zobrist hash
+ * <hashkey>), or -1 if the Key-Value pair is not in the table.
  */
 
-int getHashTableValue(char *key) {
+int hashTableGet(STATE_HASH_TABLE *table, STATE_KEY *key, uint64_t hashkey) {
+  return findHashTableSlot(table, key->words, hashkey)->value;
+}
 
-  /* Get Hash Table Index */
-  HASH_TABLE_NODE *search_node = state_hashtable[getHashKeyIndex(key)];
 
-  /* Search Hash Table for Key */
-  while (search_node != NULL) {
-    if (strcmp(search_node->key, key) == 0) {
-      return search_node->value;
-    }
-    search_node = search_node->next;
+/**
+ * Function: hashTableInsertIfAbsent
+ *
+ * Inserts a Key-Value pair into the <table>, unless the <key> is already there.
+ * Returns the Value already stored for the <key>, or -1 if it was inserted.
+ */
+
+int hashTableInsertIfAbsent(STATE_HASH_TABLE *table, STATE_KEY *key, uint64_t hashkey, int value) {
+
+  HASH_TABLE_SLOT *slot = NULL;
+
+  /* Grow the Hash Table (if it is getting too full) */
+  if ((uint64_t) (table->count + 1) * 100 > table->size * STATE_HASH_TABLE_MAX_LOAD) {
+    growStateHashTable(table);
   }
 
-  /* Otherwise, return -1 */
+  slot = findHashTableSlot(table, key->words, hashkey);
+  if (slot->value >= 0) {
+    return slot->value;
+  }
+
+  /* Fill in New State Data */
+  slot->hash  = hashkey;
+  slot->value = value;
+  memcpy(slot->key, key->words, sizeof(uint64_t) * table->key_words);
+  table->count++;
+
   return -1;
 
 }
 
 
+/**
+ * Function: insertIntoStateHashTable
+ *
+ * Inserts a Key-Value pair (with the key's Zobrist <hashkey>) into the Hash
+ * <table>.  The key is copied into the table.
+ */
+
+void insertIntoStateHashTable(STATE_HASH_TABLE *table, STATE_KEY *key, uint64_t hashkey, int value) {
+
+  if (hashTableInsertIfAbsent(table, key, hashkey, value) >= 0) {
+    findHashTableSlot(table, key->words, hashkey)->value = value;
+  }
+
+}
+
+
+/**
+ * Function: getHashTableValue
+ *
+ * Returns a Value of the <table>, given a Key.  Since the values that are stored
+ * are path-costs, all of the values must be non-negative.  Therefore, if the key
+ * is not found, this function will return -1, to indicate that the Key-Value
+ * pair is not in the table.
+ */
+
+int getHashTableValue(STATE_HASH_TABLE *table, STATE_KEY *key, uint64_t hashkey) {
+  return hashTableGet(table, key, hashkey);
+}
+
+
 /**
  * Function: updateHashTableValue
  *
- * Updates the value for the given Key.  This assumes that the Key was already
- * in the hash table.  This is useful for depth-first-search, when a new path
- * to an already visited board_state is found, but the new path is shorter.
+ * Updates the value of the <table> for the given Key.  This assumes that the Key
+ * was already in the hash table.  This is useful for depth-first-search, when a
+ * new path to an already visited board_state is found, but the new path is shorter.
  */
 
-void updateHashTableValue(char *key, int value) {
+void updateHashTableValue(STATE_HASH_TABLE *table, STATE_KEY *key, uint64_t hashkey, int value) {
 
-  /* Get Hash Table Index */
-  HASH_TABLE_NODE *search_node = state_hashtable[getHashKeyIndex(key)];
+  HASH_TABLE_SLOT *slot = findHashTableSlot(table, key->words, hashkey);
 
-  /* Search Hash Table for Key */
-  while (search_node != NULL) {
-    if (strcmp(search_node->key, key) == 0) {
-      search_node->value = value;
-      return;
-    }
-    search_node = search_node->next;
+  if (slot->value >= 0) {
+    slot->value = value;
   }
 
   return;
@@ -0,0 +1,295 @@
+/************************************************************************
+* FILENAME : transposition_table.c
+*
+* DESCRIPTION :
+*
+*       Implements a fixed-size (lossy) transposition table for the iterative
+*       deepening searches.  Unlike the closed set, the table never grows: each
+*       state's 64-bit Zobrist hash picks a bucket of TT_BUCKET_SIZE entries
+*       (one cache line), and a new state takes an empty entry of its bucket,
+*       or else replaces the deepest state there (the one with the largest g).
+*       Shallow states are the ones whose cutoffs save the most work, since
+*       each of them stands for a whole subtree, so they are the ones kept.
+*       Losing an entry only costs some extra work, so the memory used by a
+*       search stays bounded no matter how many states it visits.
+*
+*       Each entry remembers the smallest path cost (g) at which its state was
+*       reached in the current iteration, and the best lower bound (h) on its
+*       distance to the goal that has been learned so far.
+*
+*       The Shared Transposition Table is the same table, for the threads of a
+*       parallel search to share without any locks.  Its entries are copied in
+*       and out (rather than changed in place), and each entry is stored as
+*       two words: the packed g, h, and iteration, and that word XOR-ed with
+*       the state's hash.  Two threads that write the same entry at the same
+*       time may leave it with one word from each, but then the XOR no longer
+*       gives the hash back, so the entry just reads as missing (one more way
+*       for the table to lose an entry).  It uses the same buckets, and the
+*       same replacement.
+*
+* PUBLIC FUNCTIONS :
+*
+*       void ttInit(TRANSPOSITION_TABLE *table, int size_bits)
+*       void ttFree(TRANSPOSITION_TABLE *table)
+*       TT_ENTRY *ttProbe(TRANSPOSITION_TABLE *table, uint64_t hashkey)
+*       TT_ENTRY *ttStore(TRANSPOSITION_TABLE *table, uint64_t hashkey)
+*       void ttSharedInit(SHARED_TRANSPOSITION_TABLE *table, int size_bits)
+*       void ttSharedFree(SHARED_TRANSPOSITION_TABLE *table)
+*       bool ttSharedLoad(SHARED_TRANSPOSITION_TABLE *table, uint64_t hashkey, TT_ENTRY *entry)
+*       void ttSharedSave(SHARED_TRANSPOSITION_TABLE *table, TT_ENTRY *entry)
+*
+* AUTHOR : Philip Cheng
+* DATE   : 18 October 2017
+*
+************************************************************************/
+
+/* Default number of entries (as a power of 2), entries per bucket, and the
+   largest stored value */
+#define TT_DEFAULT_SIZE_BITS 20
+#define TT_BUCKET_SIZE       4
+#define TT_MAX_VALUE         INT16_MAX
+
+/* Entry in the Transposition Table (an empty entry has a zero key) */
+typedef struct TT_ENTRY {
+    uint64_t key;        /* Zobrist hash of the state              */
+    int16_t  g;          /* Smallest path cost in <iteration>      */
+    int16_t  h;          /* Lower bound on the distance to a goal  */
+    uint32_t iteration;  /* Iteration that <g> belongs to          */
+} TT_ENTRY;
+
+/* Transposition Table: a power-of-2 array of entries (in buckets) */
+typedef struct TRANSPOSITION_TABLE {
+    TT_ENTRY *entries;
+    uint64_t  mask;      /* Picks a bucket's first entry */
+    int       count;     /* Entries in use */
+} TRANSPOSITION_TABLE;
+
+/* Entry in the Shared Transposition Table (an empty entry is all zeros) */
+typedef struct SHARED_TT_ENTRY {
+    uint64_t check;      /* Zobrist hash of the state, XOR <data>  */
+    uint64_t data;       /* g, h, and iteration, packed            */
+} SHARED_TT_ENTRY;
+
+/* Shared Transposition Table: a power-of-2 array of entries (in buckets) */
+typedef struct SHARED_TRANSPOSITION_TABLE {
+    SHARED_TT_ENTRY *entries;
+    uint64_t         mask;   /* Picks a bucket's first entry */
+    int              count;  /* Entries in use (approximate) */
+} SHARED_TRANSPOSITION_TABLE;
+
+
+/**
+ * Function: ttInit
+ *
+ * Allocates an empty <table> with 2^<size_bits> entries (<size_bits> must be
+ * at least 2, so that the table holds a whole bucket).
+ */
+
+void ttInit(TRANSPOSITION_TABLE *table, int size_bits) {
+
+  table->mask    = (((uint64_t) 1 << size_bits) - 1) & ~(uint64_t) (TT_BUCKET_SIZE - 1);
+  table->count   = 0;
+  table->entries = calloc(table->mask + TT_BUCKET_SIZE, sizeof(TT_ENTRY));
+  if (table->entries == NULL) {
+    fprintf(stderr, "Out of memory (transposition table).\n");
+    exit(EXIT_FAILURE);
+  }
+
+}
+
+
+/**
+ * Function: ttFree
+ *
+ * Cleans up the memory used by the <table>.
+ */
+
+void ttFree(TRANSPOSITION_TABLE *table) {
+
+  free(table->entries);
+
+  table->entries = NULL;
+  table->mask    = 0;
+  table->count   = 0;
+
+}
+
+
+/**
+ * Function: ttProbe
+ *
+ * Returns the entry of the <table> for the state with the given <hashkey>, or
+ * NULL if that state is not in the table.
+ */
+
+TT_ENTRY *ttProbe(TRANSPOSITION_TABLE *table, uint64_t hashkey) {
+
+  int i = 0;
+  TT_ENTRY *bucket = &table->entries[hashkey & table->mask];
+
+  for (i = 0; i < TT_BUCKET_SIZE; i++) {
+    if (bucket[i].key == hashkey) {
+      return &bucket[i];
+    }
+  }
+
+  return NULL;
+
+}
+
+
+/**
+ * Function: ttStore
+ *
+ * Returns the entry of the <table> for the state with the given <hashkey>.  If
+ * the state is not in the table, it takes an empty entry of its bucket, or
+ * else replaces the state with the largest g there (the new entry has no g for
+ * any iteration, and no learned h).
+ */
+
+TT_ENTRY *ttStore(TRANSPOSITION_TABLE *table, uint64_t hashkey) {
+
+  int i = 0;
+  int entry_g = 0;
+  int victim_g = -1;
+  TT_ENTRY *bucket = &table->entries[hashkey & table->mask];
+  TT_ENTRY *entry  = bucket;
+
+  /* The state's own entry, or else the one to replace (an empty entry counts
+     as deeper than any state) */
+  for (i = 0; i < TT_BUCKET_SIZE; i++) {
+    if (bucket[i].key == hashkey) {
+      return &bucket[i];
+    }
+    entry_g = (bucket[i].key == 0) ? TT_MAX_VALUE + 1 : bucket[i].g;
+    if (entry_g > victim_g) {
+      entry = &bucket[i];
+      victim_g = entry_g;
+    }
+  }
+
+  if (entry->key == 0) {
+    table->count++;
+  }
+  entry->key       = hashkey;
+  entry->g         = TT_MAX_VALUE;
+  entry->h         = 0;
+  entry->iteration = 0;
+
+  return entry;
+
+}
+
+
+/**
+ * Function: ttSharedInit
+ *
+ * Allocates an empty shared <table> with 2^<size_bits> entries (see ttInit).
+ */
+
+void ttSharedInit(SHARED_TRANSPOSITION_TABLE *table, int size_bits) {
+
+  table->mask    = (((uint64_t) 1 << size_bits) - 1) & ~(uint64_t) (TT_BUCKET_SIZE - 1);
+  table->count   = 0;
+  table->entries = calloc(table->mask + TT_BUCKET_SIZE, sizeof(SHARED_TT_ENTRY));
+  if (table->entries == NULL) {
+    fprintf(stderr, "Out of memory (transposition table).\n");
+    exit(EXIT_FAILURE);
+  }
+
+}
+
+
+/**
+ * Function: ttSharedFree
+ *
+ * Cleans up the memory used by the shared <table>.
+ */
+
+void ttSharedFree(SHARED_TRANSPOSITION_TABLE *table) {
+
+  free(table->entries);
+
+  table->entries = NULL;
+  table->mask    = 0;
+  table->count   = 0;
+
+}
+
+
+/**
+ * Function: ttSharedLoad
+ *
+ * Copies the entry of the shared <table> for the state with the given
+ * <hashkey> into <entry>.  Returns false if that state is not in the table (or
+ * its entry was torn by two threads writing it at once).
+ */
+
+bool ttSharedLoad(SHARED_TRANSPOSITION_TABLE *table, uint64_t hashkey, TT_ENTRY *entry) {
+
+  int i = 0;
+  uint64_t check = 0;
+  uint64_t data  = 0;
+  SHARED_TT_ENTRY *bucket = &table->entries[hashkey & table->mask];
+
+  for (i = 0; i < TT_BUCKET_SIZE; i++) {
+    check = __atomic_load_n(&bucket[i].check, __ATOMIC_RELAXED);
+    data  = __atomic_load_n(&bucket[i].data, __ATOMIC_RELAXED);
+    if ((check ^ data) == hashkey) {
+      entry->key       = hashkey;
+      entry->g         = (int16_t) (data & 0xFFFF);
+      entry->h         = (int16_t) ((data >> 16) & 0xFFFF);
+      entry->iteration = (uint32_t) (data >> 32);
+      return true;
+    }
+  }
+
+  return false;
+
+}
+
+
+/**
+ * Function: ttSharedSave
+ *
+ * Copies the <entry> into the shared <table>: over the state's own entry, or
+ * else an empty entry of its bucket, or else the entry with the largest g
+ * there.
+ */
+
+void ttSharedSave(SHARED_TRANSPOSITION_TABLE *table, TT_ENTRY *entry) {
+
+  int i = 0;
+  int victim = 0;
+  int entry_g = 0;
+  int victim_g = -1;
+  uint64_t check = 0;
+  uint64_t old_data = 0;
+  SHARED_TT_ENTRY *bucket = &table->entries[entry->key & table->mask];
+  uint64_t data = (uint64_t) (uint16_t) entry->g | (uint64_t) (uint16_t) entry->h << 16 |
+                  (uint64_t) entry->iteration << 32;
+
+  /* The state's own entry, or else the one to replace (as in ttStore) */
+  for (i = 0; i < TT_BUCKET_SIZE; i++) {
+    check    = __atomic_load_n(&bucket[i].check, __ATOMIC_RELAXED);
+    old_data = __atomic_load_n(&bucket[i].data, __ATOMIC_RELAXED);
+    if ((check ^ old_data) == entry->key) {
+      victim = i;
+      victim_g = 0;
+      break;
+    }
+    entry_g = (check == 0 && old_data == 0) ? TT_MAX_VALUE + 1 : (int16_t) (old_data & 0xFFFF);
+    if (entry_g > victim_g) {
+      victim = i;
+      victim_g = entry_g;
+    }
+  }
+
+  if (victim_g == TT_MAX_VALUE + 1) {
+    __atomic_fetch_add(&table->count, 1, __ATOMIC_RELAXED);
+  }
+
+  __atomic_store_n(&bucket[victim].check, entry->key ^ data, __ATOMIC_RELAXED);
+  __atomic_store_n(&bucket[victim].data, data, __ATOMIC_RELAXED);
+
+}